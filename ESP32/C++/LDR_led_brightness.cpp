@@ -0,0 +1,63 @@
+/*
+    LDR_led_on_off.cpp with the LED dimmed in proportion to the darkness instead of switched on and off.
+
+    The ADC runs continuously as in LDR_led_on_off.cpp (AdcBlockSampler, 20 kHz, 128-sample frames). Every 100 ms
+    the latest average goes through BrightnessController (Shared/brightness.hpp): the reading becomes a perceived
+    level 0-255, the gamma table turns that into a 13-bit LEDC duty and LedcFadeOutput fades to it in 80 ms with
+    the LEDC fade hardware. Between updates the brightness changes smoothly without the CPU.
+
+    The same controller drives the MCP41010 on the Pi (SPI_0_digital_POT_MCP41010.cpp ldr).
+*/
+
+#include <cstdio>
+
+extern "C" {
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+#include "../../Shared/deadline_monitor.hpp"
+#include "../../Shared/brightness.hpp"
+#include "adc_block_sampler.hpp"
+#include "ledc_fade_output.hpp"
+
+static constexpr adc_channel_t LDR_CHANNEL = ADC_CHANNEL_0; // GPIO36
+static constexpr gpio_num_t LED_PIN = GPIO_NUM_23;
+static constexpr uint32_t SAMPLE_RATE_HZ = 20000;
+static constexpr uint32_t FRAME_BYTES = 256;                // 128 samples
+static constexpr uint32_t UPDATE_MS = 100;
+static constexpr uint32_t FADE_MS = 80;                     // done before the next update
+
+// LDR: LOW values = DARK (LED fully on), HIGH values = BRIGHT (LED off)
+static constexpr uint32_t DARK_RAW = 600;
+static constexpr uint32_t LIT_RAW = 2400;
+
+extern "C" void app_main(void)
+{
+    static LedcFadeOutput led(LED_PIN);
+    static BrightnessController<LedcFadeOutput> brightness(led, DARK_RAW, LIT_RAW, FADE_MS);
+
+    static AdcBlockSampler sampler(&LDR_CHANNEL, 1, SAMPLE_RATE_HZ, FRAME_BYTES);
+    sampler.start();
+
+    DeadlineMonitor monitor("ldr brightness", UPDATE_MS * 1000);
+    uint32_t updates = 0;
+
+    while (true) {
+        monitor.start();
+        uint32_t raw = 0;
+        if (sampler.latest(&raw)) {
+            brightness.update(raw);
+        }
+        if (++updates % 10 == 0) {
+            printf("LDR raw=%lu, level %u, duty %lu/%lu, %lu fades, %lu busy\n", (unsigned long)raw,
+                   brightness.level(), (unsigned long)led.duty(), (unsigned long)led.maxCounts(),
+                   (unsigned long)led.fades(), (unsigned long)led.busy());
+        }
+        monitor.finish();
+        DeadlineMonitor::reportIfRequested();   // type 'd' on the console
+
+        vTaskDelay(pdMS_TO_TICKS(UPDATE_MS));
+    }
+}
@@ -1,57 +1,68 @@
+/*
+    LDR on GPIO36 switching the LED on GPIO23 when it gets dark.
+
+    The ADC runs continuously at 20 kHz into 256-byte DMA frames (AdcBlockSampler, adc_block_sampler.hpp). Every
+    frame's average goes through a hysteresis in the conversion-done callback, which sets the LED directly, so the
+    LED follows the light within one frame (6.4 ms) and no task wakes up per sample. app_main only prints the
+    latest average every 200 ms, in millivolts from the calibrated table in adc_mv_table.hpp.
+*/
+
 #include <cstdio>
 
 extern "C" {
-#include "esp_adc/adc_oneshot.h"
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_check.h"
 }
 
+#include "../../Shared/deadline_monitor.hpp"
+#include "adc_block_sampler.hpp"
+#include "adc_mv_table.hpp"
+#include "gpio_out.hpp"
+
 // ADC: use GPIO36 = ADC1_CHANNEL_0
-static adc_oneshot_unit_handle_t adc_handle;
 static constexpr adc_channel_t LDR_CHANNEL = ADC_CHANNEL_0; // GPIO36
 static constexpr gpio_num_t LED_PIN = GPIO_NUM_23;
+static constexpr uint32_t SAMPLE_RATE_HZ = 20000;
+static constexpr uint32_t FRAME_BYTES = 256;                // 128 samples
 
-extern "C" void app_main(void)
+using Led = GpioOut<LED_PIN>;
+
+// LDR: LOW values = DARK (turn LED ON), HIGH values = BRIGHT (LED OFF); +-50 counts around the old threshold of 1000
+static Hysteresis darkness(950, 1050);
+static AdcMillivoltTable millivolts;          // 8 KB, static so it is in DRAM and not on the main task's stack
+
+// conversion-done interrupt, once per frame
+static void IRAM_ATTR on_frame(const uint32_t *averages, size_t, void *)
 {
-    // ---- Configure ADC1 (one-shot mode) ----
-    adc_oneshot_unit_init_cfg_t init_config = {
-        .unit_id = ADC_UNIT_1,
-    };
-    ESP_ERROR_CHECK(adc_oneshot_new_unit(&init_config, &adc_handle));
-
-    // Configure the channel
-    adc_oneshot_chan_cfg_t channel_config = {
-        .atten = ADC_ATTEN_DB_12,
-        .bitwidth = ADC_BITWIDTH_12,
-    };
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc_handle, LDR_CHANNEL, &channel_config));
+    Led::write(darkness.update(averages[0]));
+}
 
+extern "C" void app_main(void)
+{
     // ---- Configure LED GPIO (GPIO23) ----
-    gpio_config_t led_cfg = {};
-    led_cfg.pin_bit_mask = (1ULL << static_cast<uint32_t>(LED_PIN));
-    led_cfg.mode = GPIO_MODE_OUTPUT;
-    led_cfg.pull_up_en = GPIO_PULLUP_DISABLE;
-    led_cfg.pull_down_en = GPIO_PULLDOWN_DISABLE;
-    led_cfg.intr_type = GPIO_INTR_DISABLE;
-    gpio_config(&led_cfg);
+    Led::configure(false);
 
-    const int threshold = 1000; // Tune for your LDR: LOW=dark, HIGH=bright
+    // ---- Configure ADC1 (continuous mode) ----
+    millivolts.build(ADC_UNIT_1, LDR_CHANNEL, ADC_ATTEN_DB_12);
+    printf("ADC calibration: %s\n", millivolts.scheme());
+    static AdcBlockSampler sampler(&LDR_CHANNEL, 1, SAMPLE_RATE_HZ, FRAME_BYTES);
+    sampler.start(on_frame);
 
-    while (true) {
-        int raw = 0;
-        ESP_ERROR_CHECK(adc_oneshot_read(adc_handle, LDR_CHANNEL, &raw));
-        float voltage = raw * (3.3f / 4095.0f);
+    DeadlineMonitor monitor("ldr", 200000);
 
-        printf("LDR raw=%d, V=%.2f (Dark<2000, Bright>2000)\n", raw, voltage);
+    while (true) {
+        monitor.start();
+        uint32_t raw = 0;
+        if (sampler.latest(&raw)) {
+            unsigned mv = millivolts.toMillivolts(raw);
 
-        // LDR: LOW values = DARK (turn LED ON), HIGH values = BRIGHT (LED OFF)
-        if (raw < threshold) {
-            gpio_set_level(LED_PIN, 1);  // Dark → LED ON
-        } else {
-            gpio_set_level(LED_PIN, 0);  // Bright → LED OFF
+            printf("LDR raw=%lu, %u mV (Dark<2000, Bright>2000), LED %s, %lu frames\n", (unsigned long)raw,
+                   mv, darkness.on() ? "on" : "off", (unsigned long)sampler.frames());
         }
+        monitor.finish();
+        DeadlineMonitor::reportIfRequested();   // type 'd' on the console
 
         vTaskDelay(pdMS_TO_TICKS(200));
     }
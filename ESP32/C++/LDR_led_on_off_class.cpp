@@ -1,19 +1,37 @@
+/*
+    LDR controller class: the ADC samples continuously (AdcBlockSampler from adc_block_sampler.hpp, 20 kHz into
+    256-byte DMA frames) and the average of every frame drives the LED through a hysteresis around the dark
+    threshold, from the conversion-done callback. showDetails() only prints the latest average every 500 ms, converted
+    with the calibrated millivolt table (adc_mv_table.hpp).
+*/
+
 #include <stdio.h>
-#include "esp_adc/adc_oneshot.h"
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 
+#include "../../Shared/deadline_monitor.hpp"
+#include "adc_block_sampler.hpp"
+#include "adc_mv_table.hpp"
+
 static const char* TAG = "LDR";
 
+// 8 KB, static so it is in DRAM and not on the stack with the controller
+static AdcMillivoltTable millivolts;
+
 class LDRledController
 {
 private:
+    static constexpr uint32_t SAMPLE_RATE_HZ = 20000;
+    static constexpr uint32_t FRAME_BYTES = 256;        // 128 samples, one LED decision every 6.4 ms
+    static constexpr int HYSTERESIS_RAW = 50;
+
     adc_channel_t ldr_channel_;
     gpio_num_t led_pin_;
     int dark_threshold_raw_;               // changed to int
-    adc_oneshot_unit_handle_t adc_handle_ = nullptr;
+    Hysteresis dark_;
+    AdcBlockSampler sampler_;
 
     void setupLED()
     {
@@ -28,28 +46,13 @@ private:
         gpio_set_level(led_pin_, 0);
     }
 
-    void setupADC()
+    // conversion-done interrupt: raw above the threshold is dark for this divider, LED on
+    static void IRAM_ATTR onFrame(const uint32_t *averages, size_t, void *arg)
     {
-        adc_oneshot_unit_init_cfg_t init_cfg = {
-            .unit_id = ADC_UNIT_1,
-            .ulp_mode = ADC_ULP_MODE_DISABLE,
-        };
-
-        esp_err_t ret = adc_oneshot_new_unit(&init_cfg, &adc_handle_);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to init ADC unit: %s", esp_err_to_name(ret));
-            return;
-        }
-
-        adc_oneshot_chan_cfg_t chan_cfg = {
-            .atten = ADC_ATTEN_DB_12,
-            .bitwidth = ADC_BITWIDTH_12
-        };
-
-        ret = adc_oneshot_config_channel(adc_handle_, ldr_channel_, &chan_cfg);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to config ADC channel: %s", esp_err_to_name(ret));
-        }
+        auto *self = static_cast<LDRledController*>(arg);
+        // Hysteresis switches on below its lower threshold, so feed it the inverted reading
+        bool dark = self->dark_.update(4095 - averages[0]);
+        gpio_set_level(self->led_pin_, dark ? 1 : 0);
     }
 
     // Prevent copying
@@ -60,43 +63,35 @@ public:
     LDRledController(adc_channel_t ldr_channel, gpio_num_t led_pin, int dark_threshold_raw)
         : ldr_channel_(ldr_channel),
           led_pin_(led_pin),                     // ← fixed here!
-          dark_threshold_raw_(dark_threshold_raw)
+          dark_threshold_raw_(dark_threshold_raw),
+          dark_(4095 - (dark_threshold_raw + HYSTERESIS_RAW), 4095 - (dark_threshold_raw - HYSTERESIS_RAW)),
+          sampler_(&ldr_channel_, 1, SAMPLE_RATE_HZ, FRAME_BYTES)
     {
         setupLED();
-        setupADC();
-    }
-
-    ~LDRledController()
-    {
-        if (adc_handle_) {
-            adc_oneshot_del_unit(adc_handle_);
-        }
+        millivolts.build(ADC_UNIT_1, ldr_channel_, ADC_ATTEN_DB_12);
+        ESP_LOGI(TAG, "ADC calibration: %s", millivolts.scheme());
+        sampler_.start(onFrame, this);
     }
 
     void showDetails()
     {
-        int raw = 0;
+        DeadlineMonitor monitor("ldr details", 500000);
         while (true)
         {
-            if (adc_handle_ == nullptr) {
-                ESP_LOGE(TAG, "ADC not initialized!");
-                vTaskDelay(pdMS_TO_TICKS(1000));
-                continue;
-            }
-
-            esp_err_t ret = adc_oneshot_read(adc_handle_, ldr_channel_, &raw);
-            if (ret == ESP_OK)
+            monitor.start();
+            uint32_t raw = 0;
+            if (sampler_.latest(&raw))
             {
-                float voltage = raw * (3.3f / 4095.0f);
-                ESP_LOGI(TAG, "Raw: %4d   Voltage: %.3f V", raw, voltage);
-
-                // Optional: control LED based on threshold
-                // gpio_set_level(led_pin_, (raw > dark_threshold_raw_) ? 1 : 0);
+                float voltage = millivolts.toMillivolts(raw) / 1000.0f;
+                ESP_LOGI(TAG, "Raw: %4lu   Voltage: %.3f V   LED %s (dark above %d)", (unsigned long)raw, voltage,
+                         dark_.on() ? "on" : "off", dark_threshold_raw_);
             }
             else
             {
-                ESP_LOGE(TAG, "ADC read failed: %s", esp_err_to_name(ret));
+                ESP_LOGW(TAG, "No ADC frame yet");
             }
+            monitor.finish();
+            DeadlineMonitor::reportIfRequested();   // type 'd' on the console
 
             vTaskDelay(pdMS_TO_TICKS(500));   // ← very important!
         }
@@ -0,0 +1,93 @@
+/*
+    LDR_led_on_off.cpp with the ADC in continuous (DMA) mode and the samples oversampled from 12 to 16 bits.
+
+    The ADC runs at 20 kHz, DMA hands over frames of 128 samples and every 256 samples (4 extra bits) become one
+    16-bit reading, ~78 per second. The 12-bit ADC has a few LSB of noise on its own, which is what makes the
+    extra bits real. The LED threshold and the print use the oversampled value.
+*/
+
+#include <cstdio>
+#include <cstdint>
+
+extern "C" {
+#include "esp_adc/adc_continuous.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_check.h"
+}
+
+#include "../../Shared/oversample.hpp"
+
+static const char* TAG = "LDR_OS";
+
+static constexpr adc_channel_t LDR_CHANNEL = ADC_CHANNEL_0; // GPIO36
+static constexpr gpio_num_t LED_PIN = GPIO_NUM_23;
+static constexpr uint32_t SAMPLE_RATE_HZ = 20000;
+static constexpr uint32_t FRAME_BYTES = 256;                // 128 samples of 2 bytes (type 1 format)
+static constexpr unsigned EXTRA_BITS = 4;
+
+extern "C" void app_main(void)
+{
+    // ---- Configure ADC1 (continuous mode) ----
+    adc_continuous_handle_t adc_handle = nullptr;
+    adc_continuous_handle_cfg_t handle_config = {};
+    handle_config.max_store_buf_size = 4 * FRAME_BYTES;
+    handle_config.conv_frame_size = FRAME_BYTES;
+    ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_config, &adc_handle));
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = ADC_ATTEN_DB_12;
+    pattern.channel = LDR_CHANNEL;
+    pattern.unit = ADC_UNIT_1;
+    pattern.bit_width = ADC_BITWIDTH_12;
+
+    adc_continuous_config_t dig_config = {};
+    dig_config.pattern_num = 1;
+    dig_config.adc_pattern = &pattern;
+    dig_config.sample_freq_hz = SAMPLE_RATE_HZ;
+    dig_config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    dig_config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    ESP_ERROR_CHECK(adc_continuous_config(adc_handle, &dig_config));
+
+    // ---- Configure LED GPIO (GPIO23) ----
+    gpio_config_t led_cfg = {};
+    led_cfg.pin_bit_mask = (1ULL << static_cast<uint32_t>(LED_PIN));
+    led_cfg.mode = GPIO_MODE_OUTPUT;
+    led_cfg.pull_up_en = GPIO_PULLUP_DISABLE;
+    led_cfg.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    led_cfg.intr_type = GPIO_INTR_DISABLE;
+    gpio_config(&led_cfg);
+
+    // type 1 words carry the channel in bits 12..15, the mask keeps the 12 data bits
+    Oversampler oversampler(EXTRA_BITS, 0x0FFF);
+    const uint32_t full_scale = oversampler.fullScale(12);
+    const uint32_t threshold = 1000u << EXTRA_BITS;  // same point as the 12-bit threshold of 1000
+
+    ESP_ERROR_CHECK(adc_continuous_start(adc_handle));
+
+    // adc_continuous_read() copies bytes, the buffer is uint16 words so the oversampler can read it directly
+    alignas(4) static uint16_t frame[FRAME_BYTES / 2];
+    uint32_t out[FRAME_BYTES / 2];
+    uint32_t readings = 0;
+    while (true) {
+        uint32_t bytes = 0;
+        esp_err_t ret = adc_continuous_read(adc_handle, reinterpret_cast<uint8_t*>(frame), FRAME_BYTES, &bytes, 1000);
+        if (ret == ESP_ERR_TIMEOUT) {
+            continue;
+        }
+        ESP_ERROR_CHECK(ret);
+
+        size_t n = oversampler.process(frame, bytes / 2, out);
+        for (size_t i = 0; i < n; i++) {
+            // LDR: LOW values = DARK (turn LED ON), HIGH values = BRIGHT (LED OFF)
+            gpio_set_level(LED_PIN, out[i] < threshold ? 1 : 0);
+
+            if (++readings % 40 == 0) {
+                float voltage = out[i] * (3.3f / full_scale);
+                ESP_LOGI(TAG, "LDR %lu/%lu (16 bit), V=%.4f", (unsigned long)out[i], (unsigned long)full_scale, voltage);
+            }
+        }
+    }
+}
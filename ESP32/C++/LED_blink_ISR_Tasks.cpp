@@ -1,19 +1,60 @@
+/*
+    LED blinking from app_main, a button on GPIO 22 pauses / resumes it.
+
+    Button path, nothing in it sleeps:
+
+        ISR             stamps the falling edge with esp_timer_get_time(), masks its own interrupt, pushes an Edge
+                        record into a statically allocated queue and starts the debounce one-shot
+        esp_timer       DEBOUNCE_US later reads the pin, pushes a Settled record with the level and unmasks the
+                        interrupt again
+        button task     waits on the queue: Edge records give the ISR-to-task latency, a Settled record with the
+                        button still down is a press (toggles should_blink), one with the button up was a bounce
+
+    Edges that get through while the window is open (before the mask took effect) are counted as bounces as well.
+    Every press logs the latency (last / max) and how many bounce edges were rejected so far.
+*/
+
 #include <cstdint>
+#include <atomic>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "../../Shared/deadline_monitor.hpp"
+#include "gpio_out.hpp"
+#include "../Common/deferred_log.h"
 
 static const char *TAG = "LED_BLINK";
 
 constexpr gpio_num_t BUTTON_PIN = GPIO_NUM_22;  // ← change if needed
+constexpr int64_t DEBOUNCE_US = 30000;
+constexpr size_t BUTTON_QUEUE_LENGTH = 16;
+
+struct ButtonEvent {
+    enum Kind : uint8_t { Edge, Settled };
+    Kind kind;
+    uint8_t level;          // Settled: pin level at the end of the window
+    int64_t time_us;        // esp_timer_get_time() in the ISR / timer callback
+};
 
+// The LED pin is a template parameter so toggling is a single GPIO register store (gpio_out.hpp)
+template <gpio_num_t led_pin>
 class LEDBlinkController {
 private:
-    gpio_num_t led_pin;
     bool led_state = false;
-    static TaskHandle_t blinkControlTaskHandle;
-    static volatile bool should_blink;
+    static inline TaskHandle_t blinkControlTaskHandle = NULL;
+    static inline std::atomic<bool> should_blink{true};
+
+    static inline QueueHandle_t buttonQueue = NULL;
+    static inline StaticQueue_t buttonQueueBuffer;
+    static inline uint8_t buttonQueueStorage[BUTTON_QUEUE_LENGTH * sizeof(ButtonEvent)];
+    static inline esp_timer_handle_t debounceTimer = NULL;
+    static inline std::atomic<bool> debouncing{false};
+    static inline std::atomic<uint32_t> bounceEdges{0};      // edges inside an open window + windows that ended released
+    static inline std::atomic<uint32_t> droppedEvents{0};    // queue full
 
     void log_error_helper(esp_err_t err, const char* operation) const {
         if (err != ESP_OK) {
@@ -35,45 +76,100 @@ private:
             log_error_helper(ret, "LED setup");
         }
 
-        esp_err_t ret1 = gpio_set_level(led_pin, 0);
-        log_error_helper(ret1, "initial led value setup");
+        GpioOut<led_pin>::clear();
         ESP_LOGI(TAG, "LED state -=-=-==- %d → %s", led_pin, "on");
     }
 
     // ISR - must be static because it's called from C context
     static void IRAM_ATTR button_isr_handler(void* arg) {
+        int64_t now = esp_timer_get_time();
+        if (debouncing.exchange(true)) {
+            bounceEdges.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        gpio_intr_disable(BUTTON_PIN);
+        esp_timer_start_once(debounceTimer, DEBOUNCE_US);
+
+        ButtonEvent ev = {ButtonEvent::Edge, 0, now};
         BaseType_t higher = pdFALSE;
-        vTaskNotifyGiveFromISR(blinkControlTaskHandle, &higher);
+        if (xQueueSendFromISR(buttonQueue, &ev, &higher) != pdTRUE) {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        }
         portYIELD_FROM_ISR(higher);
     }
 
+    // End of the bounce window, runs in the esp_timer task
+    static void debounce_timer_callback(void *arg) {
+        ButtonEvent ev = {ButtonEvent::Settled, static_cast<uint8_t>(gpio_get_level(BUTTON_PIN)), esp_timer_get_time()};
+        if (xQueueSend(buttonQueue, &ev, 0) != pdTRUE) {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        }
+        debouncing.store(false);
+        gpio_intr_enable(BUTTON_PIN);
+    }
+
     // Button handling task - static because created from constructor
     static void button_control_task(void *pvParameters) {
+        int64_t lastLatency = 0, maxLatency = 0, edgeTime = 0;
+        uint32_t presses = 0;
+        ButtonEvent ev;
         while (true) {
-            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-            
-            vTaskDelay(pdMS_TO_TICKS(50));  // basic debounce
-            
-            if (gpio_get_level(BUTTON_PIN) == 0) {
-                should_blink = !should_blink;
-                ESP_LOGI(TAG, "Button pressed → blinking %s", 
-                         should_blink ? "ENABLED" : "PAUSED");
+            xQueueReceive(buttonQueue, &ev, portMAX_DELAY);
+            int64_t now = esp_timer_get_time();
+
+            if (ev.kind == ButtonEvent::Edge) {
+                edgeTime = ev.time_us;
+                lastLatency = now - ev.time_us;
+                if (lastLatency > maxLatency) {
+                    maxLatency = lastLatency;
+                }
+                continue;
+            }
+
+            if (ev.level != 0) {
+                // released again before the window ended
+                bounceEdges.fetch_add(1, std::memory_order_relaxed);
+                continue;
             }
+            presses++;
+            bool blinking = !should_blink.load();
+            should_blink.store(blinking);
+            ESP_LOGI(TAG, "Button pressed → blinking %s (press %lu, ISR to task %lld us, max %lld us, "
+                     "confirmed %lld us after the edge, %lu bounce edges rejected, %lu events dropped)",
+                     blinking ? "ENABLED" : "PAUSED", static_cast<unsigned long>(presses), lastLatency,
+                     maxLatency, ev.time_us - edgeTime, static_cast<unsigned long>(bounceEdges.load()),
+                     static_cast<unsigned long>(droppedEvents.load()));
         }
     }
 
     void setup_button_interrupt() {
+        buttonQueue = xQueueCreateStatic(BUTTON_QUEUE_LENGTH, sizeof(ButtonEvent), buttonQueueStorage,
+                                         &buttonQueueBuffer);
+
+        esp_timer_create_args_t timer_args = {};
+        timer_args.callback = debounce_timer_callback;
+        timer_args.dispatch_method = ESP_TIMER_TASK;
+        timer_args.name = "btn_debounce";
+        esp_err_t ret = esp_timer_create(&timer_args, &debounceTimer);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Debounce timer create failed");
+            return;
+        }
+
         gpio_config_t io_conf = {};
         io_conf.pin_bit_mask = (1ULL << BUTTON_PIN);
         io_conf.mode         = GPIO_MODE_INPUT;
         io_conf.pull_up_en   = GPIO_PULLUP_ENABLE;
         io_conf.intr_type    = GPIO_INTR_NEGEDGE;  // falling edge = press
-        esp_err_t ret = gpio_config(&io_conf);
+        ret = gpio_config(&io_conf);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Button GPIO config failed");
             return;
         }
 
+        // Create the button handling task before the first edge can arrive
+        xTaskCreate(button_control_task, "btn_ctrl", 3072, NULL, 10, &blinkControlTaskHandle);
+
         // Install ISR service (only once)
         ret = gpio_install_isr_service(0);
         if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {  // already installed is ok
@@ -83,14 +179,11 @@ private:
 
         // Add handler
         gpio_isr_handler_add(BUTTON_PIN, button_isr_handler, NULL);
-
-        // Create the button handling task
-        xTaskCreate(button_control_task, "btn_ctrl", 2048, NULL, 10, &blinkControlTaskHandle);
     }
 
 public:
-    LEDBlinkController(gpio_num_t led_pin_param, bool initial_led_state) 
-        : led_pin(led_pin_param), led_state(initial_led_state) 
+    explicit LEDBlinkController(bool initial_led_state) 
+        : led_state(initial_led_state) 
     {
         setup_LED_config();
         setup_button_interrupt();  // ← button + interrupt + task setup here
@@ -98,31 +191,28 @@ public:
     }
 
     void toggle_LED_states() {
-        if (!should_blink) return;
+        if (!should_blink.load(std::memory_order_relaxed)) return;
 
         led_state = !led_state;
-        esp_err_t ret = gpio_set_level(led_pin, led_state ? 1 : 0);
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "LED state -=-=-==- %d → %d", led_pin, led_state);
-        } else {
-            log_error_helper(ret, "set LED level");
-        }
+        GpioOut<led_pin>::write(led_state);
+        DLOG("LED state -=-=-==- %d → %d", led_pin, led_state);
     }
 };
 
-// Static members initialization
-TaskHandle_t LEDBlinkController::blinkControlTaskHandle = NULL;
-volatile bool LEDBlinkController::should_blink = true;
-
 extern "C" void app_main(void) 
 {
     constexpr gpio_num_t led_pin = GPIO_NUM_23;
     bool led_state = false;
 
-    LEDBlinkController controller(led_pin, led_state);
+    deferred_log_init(1, 100);
+    LEDBlinkController<led_pin> controller(led_state);
+    DeadlineMonitor monitor("blink", 300000);
 
     while(true) {
+        monitor.start();
         controller.toggle_LED_states();
+        monitor.finish();
+        DeadlineMonitor::reportIfRequested();   // type 'd' on the console
         vTaskDelay(pdMS_TO_TICKS(300));
     }
 }
@@ -0,0 +1,181 @@
+/*
+    ADC1 in continuous (DMA) mode with the block average of every frame computed in the conversion-done callback.
+
+    The DMA fills frames of frame_bytes (2 bytes per sample, the channels take turns in the order given) at
+    sample_rate_hz, 20 kHz to 2 MHz on the ESP32. When a frame is complete the driver calls onConvDone() from its
+    interrupt; that sums the samples per channel and hands the averages to the FrameHandler, still in the
+    interrupt, so an LED can follow the light one frame (128 samples at 20 kHz = 6.4 ms) after it changed.
+    Nothing else runs per sample and no task wakes up for the data.
+
+    Tasks read the latest averages with latest(), which retries if a frame completed while it was copying.
+    The driver's own ring buffer is never read, flush_pool lets it drop the raw data instead of reporting overflows.
+
+    Hysteresis turns an average into an on/off decision with separate on and off thresholds, so a reading sitting
+    on the threshold doesn't make the LED flicker.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+extern "C" {
+#include "esp_adc/adc_continuous.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+}
+
+// on while the value is below on_below, off again once it is above off_above (on_below <= off_above)
+class Hysteresis {
+private:
+    uint32_t on_below_;
+    uint32_t off_above_;
+    bool on_ = false;
+
+public:
+    Hysteresis(uint32_t on_below, uint32_t off_above) : on_below_(on_below), off_above_(off_above) {}
+
+    bool update(uint32_t value) {
+        if (on_ && value > off_above_) {
+            on_ = false;
+        } else if (!on_ && value < on_below_) {
+            on_ = true;
+        }
+        return on_;
+    }
+
+    bool on() const { return on_; }
+};
+
+class AdcBlockSampler {
+public:
+    static constexpr size_t maxChannels = 8;
+    // ISR context, averages[i] belongs to the i-th channel passed to the constructor
+    using FrameHandler = void (*)(const uint32_t *averages, size_t count, void *arg);
+
+private:
+    adc_continuous_handle_t handle_ = nullptr;
+    adc_channel_t channels_[maxChannels];
+    size_t count_;
+    int8_t index_of_[16];                   // ADC channel number -> position in channels_, -1 if not sampled
+    FrameHandler handler_ = nullptr;
+    void *handler_arg_ = nullptr;
+
+    // written by the callback only, seq_ is odd while averages_ is being updated
+    std::atomic<uint32_t> seq_{0};
+    uint32_t averages_[maxChannels] = {};
+    std::atomic<uint32_t> frames_{0};
+
+    static bool IRAM_ATTR onConvDone(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                     void *user_data) {
+        auto *self = static_cast<AdcBlockSampler*>(user_data);
+        uint32_t sums[maxChannels] = {};
+        uint32_t counts[maxChannels] = {};
+
+        const auto *words = reinterpret_cast<const adc_digi_output_data_t*>(edata->conv_frame_buffer);
+        const size_t n = edata->size / SOC_ADC_DIGI_RESULT_BYTES;
+        for (size_t i = 0; i < n; i++) {
+            int idx = self->index_of_[words[i].type1.channel & 0x0F];
+            if (idx >= 0) {
+                sums[idx] += words[i].type1.data;
+                counts[idx]++;
+            }
+        }
+
+        uint32_t seq = self->seq_.load(std::memory_order_relaxed);
+        self->seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t c = 0; c < self->count_; c++) {
+            if (counts[c]) {
+                self->averages_[c] = (sums[c] + counts[c] / 2) / counts[c];
+            }
+        }
+        self->seq_.store(seq + 2, std::memory_order_release);
+        self->frames_.fetch_add(1, std::memory_order_relaxed);
+
+        if (self->handler_) {
+            self->handler_(self->averages_, self->count_, self->handler_arg_);
+        }
+        return false;
+    }
+
+    // Prevent copying
+    AdcBlockSampler(const AdcBlockSampler&) = delete;
+    AdcBlockSampler& operator=(const AdcBlockSampler&) = delete;
+
+public:
+    // frame_bytes: a multiple of 2 * count, e.g. 256 = 128 samples
+    AdcBlockSampler(const adc_channel_t *channels, size_t count, uint32_t sample_rate_hz, uint32_t frame_bytes,
+                    adc_atten_t atten = ADC_ATTEN_DB_12)
+        : count_(count < maxChannels ? count : maxChannels)
+    {
+        for (auto &i : index_of_) {
+            i = -1;
+        }
+
+        adc_continuous_handle_cfg_t handle_config = {};
+        handle_config.max_store_buf_size = 4 * frame_bytes;
+        handle_config.conv_frame_size = frame_bytes;
+        handle_config.flags.flush_pool = 1;
+        ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_config, &handle_));
+
+        adc_digi_pattern_config_t patterns[maxChannels] = {};
+        for (size_t c = 0; c < count_; c++) {
+            channels_[c] = channels[c];
+            index_of_[channels[c] & 0x0F] = static_cast<int8_t>(c);
+            patterns[c].atten = atten;
+            patterns[c].channel = channels[c];
+            patterns[c].unit = ADC_UNIT_1;
+            patterns[c].bit_width = ADC_BITWIDTH_12;
+        }
+
+        adc_continuous_config_t dig_config = {};
+        dig_config.pattern_num = count_;
+        dig_config.adc_pattern = patterns;
+        dig_config.sample_freq_hz = sample_rate_hz;
+        dig_config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+        dig_config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+        ESP_ERROR_CHECK(adc_continuous_config(handle_, &dig_config));
+
+        adc_continuous_evt_cbs_t cbs = {};
+        cbs.on_conv_done = onConvDone;
+        ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(handle_, &cbs, this));
+    }
+
+    ~AdcBlockSampler() {
+        if (handle_) {
+            adc_continuous_stop(handle_);
+            adc_continuous_deinit(handle_);
+        }
+    }
+
+    // handler may be null, then latest() is the only way to see the data
+    void start(FrameHandler handler = nullptr, void *arg = nullptr) {
+        handler_ = handler;
+        handler_arg_ = arg;
+        ESP_ERROR_CHECK(adc_continuous_start(handle_));
+    }
+
+    void stop() {
+        ESP_ERROR_CHECK(adc_continuous_stop(handle_));
+    }
+
+    // Copies the averages of the last complete frame, false before the first frame
+    bool latest(uint32_t *averages) const {
+        uint32_t before, after;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            for (size_t c = 0; c < count_; c++) {
+                averages[c] = averages_[c];
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return before != 0;
+    }
+
+    uint32_t frames() const { return frames_.load(std::memory_order_relaxed); }
+    size_t channels() const { return count_; }
+    adc_channel_t channel(size_t i) const { return channels_[i]; }
+};
@@ -0,0 +1,107 @@
+/*
+    Calibrated 12-bit ADC1 reading to millivolts with one table lookup.
+
+    The ESP32 ADC is neither linear nor does it reach 3.3 V at 4095: with 12 dB attenuation it flattens out above
+    ~2.5 V and its gain varies from chip to chip, so raw * (3.3f / 4095.0f) can be off by 100 mV and more.
+    adc_cali corrects that with the eFuse values burnt in at the factory (curve fitting where the chip supports it,
+    line fitting on the original ESP32), but adc_cali_raw_to_voltage() is a function call with integer math per
+    sample and not meant for interrupts.
+
+    build() runs the calibration scheme once for all 4096 raw values and keeps the results in a uint16_t table
+    (8 KB). toMillivolts() is then a single load; the table lives wherever the object does, a static or global
+    object is in internal DRAM, so the lookup is safe from ISRs and ADC callbacks (not in PSRAM). Chips without
+    calibration eFuses get the linear formula, calibrated() tells which.
+
+    adc_mv_table_compare.cpp measures the difference to the formula and the cycles per conversion.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+extern "C" {
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_log.h"
+}
+
+class AdcMillivoltTable {
+public:
+    static constexpr size_t size = 4096;
+
+private:
+    uint16_t mv_[size];
+    const char *scheme_ = "none";
+
+    // Prevent copying
+    AdcMillivoltTable(const AdcMillivoltTable&) = delete;
+    AdcMillivoltTable& operator=(const AdcMillivoltTable&) = delete;
+
+public:
+    AdcMillivoltTable() {
+        for (size_t raw = 0; raw < size; raw++) {
+            mv_[raw] = static_cast<uint16_t>((raw * 3300 + 2047) / 4095);
+        }
+    }
+
+    // Returns true if a calibration scheme was available, otherwise the table keeps the linear formula
+    bool build(adc_unit_t unit, adc_channel_t channel, adc_atten_t atten) {
+        adc_cali_handle_t handle = nullptr;
+        esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        adc_cali_curve_fitting_config_t curve = {};
+        curve.unit_id = unit;
+        curve.chan = channel;
+        curve.atten = atten;
+        curve.bitwidth = ADC_BITWIDTH_12;
+        ret = adc_cali_create_scheme_curve_fitting(&curve, &handle);
+        if (ret == ESP_OK) {
+            scheme_ = "curve fitting";
+        }
+#endif
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+        if (ret != ESP_OK) {
+            adc_cali_line_fitting_config_t line = {};
+            line.unit_id = unit;
+            line.atten = atten;
+            line.bitwidth = ADC_BITWIDTH_12;
+            ret = adc_cali_create_scheme_line_fitting(&line, &handle);
+            if (ret == ESP_OK) {
+                scheme_ = "line fitting";
+            }
+        }
+#endif
+        (void)channel;
+        if (ret != ESP_OK) {
+            ESP_LOGW("ADC_MV", "no ADC calibration on this chip, using the linear formula");
+            return false;
+        }
+
+        for (size_t raw = 0; raw < size; raw++) {
+            int mv = 0;
+            if (adc_cali_raw_to_voltage(handle, static_cast<int>(raw), &mv) == ESP_OK) {
+                mv_[raw] = static_cast<uint16_t>(mv);
+            }
+        }
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        if (scheme_[0] == 'c') {
+            adc_cali_delete_scheme_curve_fitting(handle);
+            return true;
+        }
+#endif
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_line_fitting(handle);
+#endif
+        return true;
+    }
+
+    // raw is a 12-bit reading (or a block average of them), higher bits are ignored
+    inline uint16_t toMillivolts(uint32_t raw) const { return mv_[raw & (size - 1)]; }
+
+    bool calibrated() const { return scheme_[0] != 'n'; }
+    const char *scheme() const { return scheme_; }
+    const uint16_t *data() const { return mv_; }
+};
@@ -0,0 +1,88 @@
+/*
+    adc_mv_table.hpp against raw * (3.3f / 4095.0f): how far apart the two are over all 4096 raw values, and the
+    CPU cycles per conversion of the formula, adc_cali_raw_to_voltage() (measured while the table is built) and
+    the table lookup.
+
+    The calibrated values are what the eFuse calibration says the pin saw, so "difference" here is the error of
+    the formula. To check the table itself, feed GPIO36 from a known voltage and compare with a multimeter.
+*/
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+
+extern "C" {
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+}
+
+#include "adc_mv_table.hpp"
+
+static AdcMillivoltTable table;
+static constexpr int ROUNDS = 16;
+
+extern "C" void app_main(void)
+{
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    bool calibrated = table.build(ADC_UNIT_1, ADC_CHANNEL_0, ADC_ATTEN_DB_12);
+    uint32_t buildCycles = esp_cpu_get_cycle_count() - t0;
+    printf("calibration: %s\n", table.scheme());
+
+    // accuracy
+    int worst = 0, worstRaw = 0;
+    int64_t total = 0;
+    for (uint32_t raw = 0; raw < AdcMillivoltTable::size; raw++) {
+        int formula = static_cast<int>(raw * (3.3f / 4095.0f) * 1000.0f + 0.5f);
+        int diff = std::abs(formula - table.toMillivolts(raw));
+        total += diff;
+        if (diff > worst) {
+            worst = diff;
+            worstRaw = raw;
+        }
+    }
+    printf("formula vs calibrated: mean %.1f mV, worst %d mV at raw %d (%d mV calibrated)\n",
+           static_cast<double>(total) / AdcMillivoltTable::size, worst, worstRaw, table.toMillivolts(worstRaw));
+    for (uint32_t raw : {0u, 500u, 1000u, 2000u, 3000u, 3500u, 4000u, 4095u}) {
+        printf("  raw %4lu: formula %4d mV, calibrated %4u mV\n", static_cast<unsigned long>(raw),
+               static_cast<int>(raw * (3.3f / 4095.0f) * 1000.0f + 0.5f), table.toMillivolts(raw));
+    }
+
+    // cost per conversion, interrupts off so a tick doesn't land in a measurement
+    volatile float sinkF = 0;
+    volatile uint32_t sinkU = 0;
+
+    portDISABLE_INTERRUPTS();
+    t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < ROUNDS; r++) {
+        float acc = 0;
+        for (uint32_t raw = 0; raw < AdcMillivoltTable::size; raw++) {
+            acc += raw * (3.3f / 4095.0f);
+        }
+        sinkF = sinkF + acc;
+    }
+    uint32_t formulaCycles = esp_cpu_get_cycle_count() - t0;
+
+    t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < ROUNDS; r++) {
+        uint32_t acc = 0;
+        for (uint32_t raw = 0; raw < AdcMillivoltTable::size; raw++) {
+            acc += table.toMillivolts(raw);
+        }
+        sinkU = sinkU + acc;
+    }
+    uint32_t tableCycles = esp_cpu_get_cycle_count() - t0;
+    portENABLE_INTERRUPTS();
+
+    const float conversions = ROUNDS * static_cast<float>(AdcMillivoltTable::size);
+    printf("cycles per conversion (loop included):\n");
+    printf("  raw * (3.3f / 4095.0f)     %6.1f\n", formulaCycles / conversions);
+    if (calibrated) {
+        printf("  adc_cali_raw_to_voltage    %6.1f  (table build, %lu us in total)\n",
+               buildCycles / static_cast<float>(AdcMillivoltTable::size),
+               static_cast<unsigned long>(buildCycles / esp_rom_get_cpu_ticks_per_us()));
+    }
+    printf("  table lookup               %6.1f\n", tableCycles / conversions);
+}
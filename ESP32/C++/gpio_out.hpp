@@ -0,0 +1,157 @@
+/*
+    Output pins with the pin number as a template parameter, written straight to the GPIO set / clear registers.
+
+    gpio_set_level() checks the pin number and goes through the HAL on every call. With the pin known at compile
+    time the mask is a constant and set() / clear() are a single store to GPIO.out_w1ts / out_w1tc (out1_w1ts /
+    out1_w1tc for GPIO 32-33). The write-1-to-set / write-1-to-clear registers only touch the bits that are 1, so
+    there is no read-modify-write and another task or an ISR writing other pins at the same time can't undo it.
+
+    GpioBank<Pins...> does the same for several pins: set() / clear() switch the whole bank with one store,
+    write(bits) switches every pin going high in one store and every pin going low in the next, a few CPU cycles
+    apart. Bit i of bits belongs to the i-th pin of the list.
+
+    configure() still goes through gpio_config(), it runs once. gpio_out_benchmark.cpp compares the cycles.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+extern "C" {
+#include "driver/gpio.h"
+#include "soc/gpio_struct.h"
+}
+
+namespace gpio_out_detail {
+
+// GPIO 34-39 are input only on the ESP32
+constexpr bool isOutputPin(gpio_num_t pin) {
+    return pin >= 0 && pin < 34;
+}
+
+constexpr std::uint32_t lowMask(gpio_num_t pin) {
+    return pin < 32 ? 1u << pin : 0u;
+}
+
+constexpr std::uint32_t highMask(gpio_num_t pin) {
+    return pin >= 32 ? 1u << (pin - 32) : 0u;
+}
+
+inline void setMasks(std::uint32_t low, std::uint32_t high) {
+    if(low) {
+        GPIO.out_w1ts = low;
+    }
+    if(high) {
+        GPIO.out1_w1ts.val = high;
+    }
+}
+
+inline void clearMasks(std::uint32_t low, std::uint32_t high) {
+    if(low) {
+        GPIO.out_w1tc = low;
+    }
+    if(high) {
+        GPIO.out1_w1tc.val = high;
+    }
+}
+
+inline void configureOutputs(std::uint64_t mask) {
+    gpio_config_t cfg{};
+    cfg.pin_bit_mask = mask;
+    cfg.mode = GPIO_MODE_OUTPUT;
+    cfg.pull_up_en = GPIO_PULLUP_DISABLE;
+    cfg.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    cfg.intr_type = GPIO_INTR_DISABLE;
+    ESP_ERROR_CHECK(gpio_config(&cfg));
+}
+
+}
+
+template <gpio_num_t Pin>
+class GpioOut {
+    static_assert(gpio_out_detail::isOutputPin(Pin), "GPIO 34-39 are input only");
+
+public:
+    static constexpr gpio_num_t pin = Pin;
+    static constexpr std::uint32_t low = gpio_out_detail::lowMask(Pin);
+    static constexpr std::uint32_t high = gpio_out_detail::highMask(Pin);
+
+    static void configure(bool initial = false) {
+        gpio_out_detail::configureOutputs(1ULL << Pin);
+        write(initial);
+    }
+
+    static inline void set() {
+        if constexpr(Pin < 32) {
+            GPIO.out_w1ts = low;
+        } else {
+            GPIO.out1_w1ts.val = high;
+        }
+    }
+
+    static inline void clear() {
+        if constexpr(Pin < 32) {
+            GPIO.out_w1tc = low;
+        } else {
+            GPIO.out1_w1tc.val = high;
+        }
+    }
+
+    static inline void write(bool level) {
+        if(level) {
+            set();
+        } else {
+            clear();
+        }
+    }
+
+    // Level the pin is driven to (the output register, not the pad)
+    static inline bool get() {
+        if constexpr(Pin < 32) {
+            return (GPIO.out & low) != 0;
+        } else {
+            return (GPIO.out1.val & high) != 0;
+        }
+    }
+
+    static inline void toggle() { write(!get()); }
+};
+
+template <gpio_num_t... Pins>
+class GpioBank {
+    static_assert(sizeof...(Pins) > 0 && sizeof...(Pins) <= 32, "1 to 32 pins");
+    static_assert((gpio_out_detail::isOutputPin(Pins) && ...), "GPIO 34-39 are input only");
+
+    static constexpr gpio_num_t pins_[] = {Pins...};
+
+public:
+    static constexpr std::size_t size = sizeof...(Pins);
+    static constexpr std::uint32_t low = (gpio_out_detail::lowMask(Pins) | ...);
+    static constexpr std::uint32_t high = (gpio_out_detail::highMask(Pins) | ...);
+    static_assert(__builtin_popcount(low) + __builtin_popcount(high) == sizeof...(Pins), "pin listed twice");
+
+    static void configure(std::uint32_t initial = 0) {
+        gpio_out_detail::configureOutputs(((1ULL << Pins) | ...));
+        write(initial);
+    }
+
+    static inline void set() { gpio_out_detail::setMasks(low, high); }
+    static inline void clear() { gpio_out_detail::clearMasks(low, high); }
+
+    // Bit i drives the i-th pin
+    static inline void write(std::uint32_t bits) {
+        std::uint32_t setLow = 0, setHigh = 0;
+        for(std::size_t i = 0; i < size; i++) {
+            if(bits & (1u << i)) {
+                setLow |= gpio_out_detail::lowMask(pins_[i]);
+                setHigh |= gpio_out_detail::highMask(pins_[i]);
+            }
+        }
+        gpio_out_detail::setMasks(setLow, setHigh);
+        gpio_out_detail::clearMasks(low & ~setLow, high & ~setHigh);
+    }
+
+    template <std::size_t I>
+    using Pin = GpioOut<pins_[I]>;
+};
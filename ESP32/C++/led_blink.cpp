@@ -1,5 +1,4 @@
 #include <cstdint>
-#include <iostream>
 
 extern "C" {
 #include "driver/gpio.h"
@@ -7,61 +6,52 @@ extern "C" {
 #include "freertos/task.h"
 }
 
+#include "../../Shared/deadline_monitor.hpp"
+#include "gpio_out.hpp"
+#include "../Common/deferred_log.h"
+
+// The pin is a template parameter, on() / off() are one store to the GPIO set / clear register (gpio_out.hpp)
+template <gpio_num_t Pin>
 class Led {
 public:
-    explicit Led(gpio_num_t pin)
-        : pin_(pin), state_(false)
+    Led()
+        : state_(false)
     {
-        gpio_config_t cfg{};
-        cfg.pin_bit_mask = (1ULL << static_cast<uint32_t>(pin_));
-        cfg.mode = GPIO_MODE_OUTPUT;
-        cfg.pull_up_en = GPIO_PULLUP_DISABLE;
-        cfg.pull_down_en = GPIO_PULLDOWN_DISABLE;
-        cfg.intr_type = GPIO_INTR_DISABLE;
-        gpio_config(&cfg);
-
-         /*
-            gpio_config_t cfg = {
-            .pin_bit_mask = (1ULL << static_cast<uint32_t>(pin_)),
-            .mode = GPIO_MODE_OUTPUT,
-            .pull_up_en = GPIO_PULLUP_DISABLE,
-            .pull_down_en = GPIO_PULLDOWN_DISABLE,
-            .intr_type = GPIO_INTR_DISABLE
-            };
-            gpio_config(&cfg);
-        */
-
-        off();
+        GpioOut<Pin>::configure(false);
     }
 
     void on() {
         state_ = true;
-        gpio_set_level(pin_, 1);
+        GpioOut<Pin>::set();
     }
 
     void off() {
         state_ = false;
-        gpio_set_level(pin_, 0);
+        GpioOut<Pin>::clear();
     }
 
     void toggle() {
         state_ = !state_;
-        gpio_set_level(pin_, state_ ? 1 : 0);
-        std::cout << "level" << state_ << std::endl;
+        GpioOut<Pin>::write(state_);
+        DLOG("level %u", state_);
     }
 
 private:
-    gpio_num_t pin_;
     bool state_;
 };
 
 extern "C" void app_main(void)
 {
     constexpr gpio_num_t LED_PIN = GPIO_NUM_23;
-    Led led(LED_PIN);
+    deferred_log_init(1, 100);
+    Led<LED_PIN> led;
+    DeadlineMonitor monitor("led blink", 1000000);
 
     for (;;) {
+        monitor.start();
         led.toggle();
+        monitor.finish();
+        DeadlineMonitor::reportIfRequested();   // type 'd' on the console
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
 }
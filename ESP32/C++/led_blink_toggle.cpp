@@ -7,29 +7,23 @@ extern "C" {
 #include "freertos/task.h"
 }
 
+#include "../../Shared/deadline_monitor.hpp"
+#include "gpio_out.hpp"
+
+template <gpio_num_t Pin>
 class Led {
 
 	private:
-    	gpio_num_t pin;
 		bool state;	
 
 	public:
-		explicit Led(gpio_num_t pin) : pin(pin), state(false) {
-
-			gpio_config_t config = {
-				.pin_bit_mask = 1ULL << static_cast<std::uint32_t>(pin),
-				.mode = GPIO_MODE_OUTPUT,
-				.pull_up_en = GPIO_PULLUP_DISABLE,
-				.pull_down_en = GPIO_PULLDOWN_DISABLE,
-				.intr_type = GPIO_INTR_DISABLE
-			};
-			gpio_config(&config);
-			
+		Led() : state(false) {
+			GpioOut<Pin>::configure(false);
 		}
 		
 		void toggle_led() {
 			state = !state;
-			gpio_set_level(pin,state?1:0);
+			GpioOut<Pin>::write(state);
 			std::cout << "pin state" << state << std::endl;
 		}
 	};
@@ -37,9 +31,13 @@ class Led {
 	extern "C" void app_main(void) 
 	{
 		constexpr gpio_num_t led_pin = GPIO_NUM_23;
-		Led led(led_pin);
+		Led<led_pin> led;
+		DeadlineMonitor monitor("led toggle", 500000);
 		while(true) {
+			monitor.start();
 			led.toggle_led();
+			monitor.finish();
+			DeadlineMonitor::reportIfRequested();	// type 'd' on the console
 			vTaskDelay(pdMS_TO_TICKS(500));
 		}
 	}
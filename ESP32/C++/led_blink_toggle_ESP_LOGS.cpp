@@ -4,12 +4,17 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "../../Shared/deadline_monitor.hpp"
+#include "gpio_out.hpp"
+#include "../Common/deferred_log.h"
+
 
 static const char *TAG = "LED_BLINK";
 
+// The LED pin is a template parameter so toggling is a single GPIO register store (gpio_out.hpp)
+template <gpio_num_t led_pin>
 class LEDBlinkController {
     private:
-        gpio_num_t led_pin;
         bool led_state = false;
 
         void log_error_helper(esp_err_t err, const char* operation) const {
@@ -32,25 +37,21 @@ class LEDBlinkController {
                 log_error_helper(ret,"LED setup");
             }
 
-            esp_err_t ret1 = gpio_set_level(led_pin,0);
-            log_error_helper(ret1,"initial led value setup");
+            GpioOut<led_pin>::clear();
             ESP_LOGI(TAG, "LED state -=-=-==- %d → %s", led_pin, led_state ? "ON" : "OFF");
         }
 
     public:
 
-        LEDBlinkController(gpio_num_t led_pin, bool led_state) : led_pin(led_pin),led_state(led_state) {
+        explicit LEDBlinkController(bool led_state) : led_state(led_state) {
             setup_LED_config();
         }
 
         void toggle_LED_states() {
             led_state = !led_state;
-            esp_err_t ret = gpio_set_level(led_pin,led_state?1:0);
-            if(ret == ESP_OK) {
-                ESP_LOGI(TAG, "LED %d → %s", led_pin, led_state ? "ON" : "OFF");
-            } else {
-                log_error_helper(ret,"set LED level");
-            }
+            GpioOut<led_pin>::write(led_state);
+            // formatted later by the deferred log task, the string arguments are literals
+            DLOG("LED %d → %s", led_pin, led_state ? "ON" : "OFF");
         }
 };
 
@@ -58,9 +59,14 @@ extern "C" void app_main(void)
 {
     constexpr gpio_num_t led_pin = GPIO_NUM_23;
     bool led_state = false;
-    LEDBlinkController controller(led_pin,led_state);
+    deferred_log_init(1, 100);
+    LEDBlinkController<led_pin> controller(led_state);
+    DeadlineMonitor monitor("led blink logs", 300000);
     while(true) {
+        monitor.start();
         controller.toggle_LED_states();
+        monitor.finish();
+        DeadlineMonitor::reportIfRequested();   // type 'd' on the console
         vTaskDelay(pdMS_TO_TICKS(300));
     }
 }
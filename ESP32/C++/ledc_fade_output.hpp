@@ -0,0 +1,116 @@
+/*
+    LED on an LEDC channel, brightness changes done by the LEDC fade hardware.
+
+    fadeTo(duty, fade_ms) programs the fade with ledc_set_fade_with_time() and starts it without waiting; the LEDC
+    then steps the duty by itself every few PWM cycles until it reaches the target, the CPU is not involved until
+    the fade-end interrupt. That interrupt only clears the fading flag. On the ESP32 a running fade can't be
+    stopped and programming a new one waits for it to end, so fadeTo() returns false while a fade is still running
+    instead of blocking; BrightnessController (Shared/brightness.hpp) keeps its target and tries again on the next
+    update. Keep fade_ms below the update period and that rarely happens.
+
+    Low speed mode, 13-bit duty at 5 kHz by default. ledc_fade_func_install() is called once for all channels.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+extern "C" {
+#include "driver/ledc.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+}
+
+class LedcFadeOutput {
+private:
+    static inline bool fade_installed_ = false;
+
+    ledc_mode_t mode_ = LEDC_LOW_SPEED_MODE;
+    ledc_channel_t channel_;
+    uint32_t max_counts_;
+    uint32_t target_ = 0;
+    std::atomic<bool> fading_{false};
+    std::atomic<uint32_t> fades_{0};
+    std::atomic<uint32_t> busy_{0};
+
+    static bool IRAM_ATTR onFadeEnd(const ledc_cb_param_t *param, void *user_arg) {
+        if (param->event == LEDC_FADE_END_EVT) {
+            static_cast<LedcFadeOutput*>(user_arg)->fading_.store(false, std::memory_order_release);
+        }
+        return false;
+    }
+
+    // Prevent copying
+    LedcFadeOutput(const LedcFadeOutput&) = delete;
+    LedcFadeOutput& operator=(const LedcFadeOutput&) = delete;
+
+public:
+    LedcFadeOutput(gpio_num_t pin, ledc_channel_t channel = LEDC_CHANNEL_0, ledc_timer_t timer = LEDC_TIMER_0,
+                   uint32_t frequency_hz = 5000, ledc_timer_bit_t resolution = LEDC_TIMER_13_BIT)
+        : channel_(channel), max_counts_((1u << resolution) - 1)
+    {
+        ledc_timer_config_t timer_config = {};
+        timer_config.speed_mode = mode_;
+        timer_config.duty_resolution = resolution;
+        timer_config.timer_num = timer;
+        timer_config.freq_hz = frequency_hz;
+        timer_config.clk_cfg = LEDC_AUTO_CLK;
+        ESP_ERROR_CHECK(ledc_timer_config(&timer_config));
+
+        ledc_channel_config_t channel_config = {};
+        channel_config.gpio_num = pin;
+        channel_config.speed_mode = mode_;
+        channel_config.channel = channel_;
+        channel_config.timer_sel = timer;
+        channel_config.intr_type = LEDC_INTR_DISABLE;
+        channel_config.duty = 0;
+        channel_config.hpoint = 0;
+        ESP_ERROR_CHECK(ledc_channel_config(&channel_config));
+
+        if (!fade_installed_) {
+            ESP_ERROR_CHECK(ledc_fade_func_install(0));
+            fade_installed_ = true;
+        }
+
+        ledc_cbs_t callbacks = {};
+        callbacks.fade_cb = onFadeEnd;
+        ESP_ERROR_CHECK(ledc_cb_register(mode_, channel_, &callbacks, this));
+    }
+
+    uint32_t maxCounts() const { return max_counts_; }
+
+    // fade_ms 0 sets the duty at once. False while the previous fade is still running
+    bool fadeTo(uint32_t duty, uint32_t fade_ms) {
+        if (fading_.load(std::memory_order_acquire)) {
+            busy_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (duty > max_counts_) {
+            duty = max_counts_;
+        }
+        // a fade to the current duty has no steps and no end interrupt
+        if (duty == ledc_get_duty(mode_, channel_)) {
+            target_ = duty;
+            return true;
+        }
+        if (fade_ms == 0) {
+            ESP_ERROR_CHECK(ledc_set_duty(mode_, channel_, duty));
+            ESP_ERROR_CHECK(ledc_update_duty(mode_, channel_));
+        } else {
+            fading_.store(true, std::memory_order_relaxed);
+            ESP_ERROR_CHECK(ledc_set_fade_with_time(mode_, channel_, duty, static_cast<int>(fade_ms)));
+            ESP_ERROR_CHECK(ledc_fade_start(mode_, channel_, LEDC_FADE_NO_WAIT));
+            fades_.fetch_add(1, std::memory_order_relaxed);
+        }
+        target_ = duty;
+        return true;
+    }
+
+    bool fading() const { return fading_.load(std::memory_order_relaxed); }
+    uint32_t target() const { return target_; }
+    uint32_t duty() const { return ledc_get_duty(mode_, channel_); }
+    uint32_t fades() const { return fades_.load(std::memory_order_relaxed); }
+    // fadeTo() calls turned away because a fade was running
+    uint32_t busy() const { return busy_.load(std::memory_order_relaxed); }
+};
@@ -5,14 +5,19 @@
 #include <freertos/task.h>
 #include <array>
 
+#include "../../Shared/deadline_monitor.hpp"
+#include "gpio_out.hpp"
+
 const static char *TAG = "TWO LEDs TOGGLE";
 
+// Both pins are template parameters: every toggle is one store to the GPIO set / clear register and
+// setLEDs() switches the pair together (gpio_out.hpp)
+template <gpio_num_t ledRED, gpio_num_t ledBLUE>
 class LEDsToggle {
 
 	private:
-		std::array<gpio_num_t,2U> pinsArray;
-		gpio_num_t ledRED;
-		gpio_num_t ledBLUE;
+		using Bank = GpioBank<ledRED, ledBLUE>;
+		static constexpr std::array<gpio_num_t,2U> pinsArray = {ledRED, ledBLUE};
 		bool ledStateRED;
 		bool ledStateBLUE;
 
@@ -44,22 +49,11 @@ class LEDsToggle {
 				errorLogHelper(err,"leds config");
 			}
 
-			esp_err_t errLevel1 = gpio_set_level(pinsArray[0], ledStateRED ? 1 : 0);
-			esp_err_t errLevel2 = gpio_set_level(pinsArray[1], ledStateBLUE ? 1 : 0);
-
-			if (errLevel1 != ESP_OK) {
-				errorLogHelper(errLevel1, "set LED RED level");
-			}
-			if (errLevel2 != ESP_OK) {
-				errorLogHelper(errLevel2, "set LED BLUE level");
-			};
+			Bank::write((ledStateRED ? 1u : 0u) | (ledStateBLUE ? 2u : 0u));
 		}
 
 	public:
-		LEDsToggle(const std::array<gpio_num_t,2U> &pinsArray, bool ledStateRED, bool ledStateBLUE):
-		pinsArray(pinsArray),      
-		ledRED(pinsArray[0]),       
-		ledBLUE(pinsArray[1]),     
+		LEDsToggle(bool ledStateRED, bool ledStateBLUE):
 		ledStateRED(ledStateRED),  
 		ledStateBLUE(ledStateBLUE) 
 		{
@@ -68,34 +62,39 @@ class LEDsToggle {
 				
 		void toggleLEDred() {
 			ledStateRED = !ledStateRED;
-			esp_err_t redLEDerr = gpio_set_level(pinsArray[0],ledStateRED?1:0);
-			if(redLEDerr != ESP_OK) {
-				errorLogHelper(redLEDerr,"toggle red led");
-			}
+			Bank::template Pin<0>::write(ledStateRED);
 		}
 
 		void toggleLEDblue() {
 			ledStateBLUE = !ledStateBLUE;
-			esp_err_t blueLEDerr = gpio_set_level(pinsArray[1],ledStateBLUE?1:0);
-			if(blueLEDerr != ESP_OK) {
-				errorLogHelper(blueLEDerr,"toggle blue led");
-			}
+			Bank::template Pin<1>::write(ledStateBLUE);
+		}
+
+		// Both LEDs in one bank update: the LED going on and the one going off switch a few CPU cycles apart
+		void setLEDs(bool red, bool blue) {
+			ledStateRED = red;
+			ledStateBLUE = blue;
+			Bank::write((red ? 1u : 0u) | (blue ? 2u : 0u));
 		}
 };
 
 extern "C" void app_main(void)
 {
-	constexpr auto pinsArray = std::array<gpio_num_t,2>{GPIO_NUM_23,GPIO_NUM_22};
-	LEDsToggle ledsController(pinsArray,false,false);
+	LEDsToggle<GPIO_NUM_23,GPIO_NUM_22> ledsController(false,false);
+	// one iteration per 100 ms half of the blue / red cycle
+	DeadlineMonitor monitor("two leds", 100000);
 
 	while(true) {
-		ledsController.toggleLEDblue();
+		monitor.start();
+		ledsController.setLEDs(false,true);		// blue
+		monitor.finish();
 		vTaskDelay(pdMS_TO_TICKS(100));
-		ledsController.toggleLEDblue();
 
-		ledsController.toggleLEDred();
+		monitor.start();
+		ledsController.setLEDs(true,false);		// red
+		monitor.finish();
+		DeadlineMonitor::reportIfRequested();	// type 'd' on the console
 		vTaskDelay(pdMS_TO_TICKS(100));
-		ledsController.toggleLEDred();
 	}
 
 }
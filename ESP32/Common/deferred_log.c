@@ -0,0 +1,105 @@
+#include "deferred_log.h"
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef struct {
+    _Atomic(const char *) fmt;      // NULL until the record is complete
+    uint32_t cycles;
+    uint32_t args[3];
+} deferred_log_record_t;
+
+typedef struct {
+    _Atomic uint32_t head;          // next slot to claim
+    _Atomic uint32_t tail;          // next slot to drain
+    _Atomic uint32_t dropped;
+    uint32_t reported_drops;        // drain task only
+    uint32_t last_cycles;
+    deferred_log_record_t records[DEFERRED_LOG_CAPACITY];
+} deferred_log_ring_t;
+
+_Static_assert((DEFERRED_LOG_CAPACITY & (DEFERRED_LOG_CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+static DRAM_ATTR deferred_log_ring_t rings[portNUM_PROCESSORS];
+static uint32_t drain_period_ticks;
+
+void IRAM_ATTR deferred_log_write(const char *fmt, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+    deferred_log_ring_t *ring = &rings[esp_cpu_get_core_id()];
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    do {
+        if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= DEFERRED_LOG_CAPACITY) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&ring->head, &head, head + 1, memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    deferred_log_record_t *rec = &ring->records[head & (DEFERRED_LOG_CAPACITY - 1)];
+    rec->cycles = esp_cpu_get_cycle_count();
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+    atomic_store_explicit(&rec->fmt, fmt, memory_order_release);
+}
+
+uint32_t deferred_log_dropped(int core)
+{
+    return atomic_load_explicit(&rings[core].dropped, memory_order_relaxed);
+}
+
+// Prints the completed records of one ring in order, stops at one that is claimed but not written yet
+static void drain_ring(int core)
+{
+    deferred_log_ring_t *ring = &rings[core];
+    const uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    while (tail != atomic_load_explicit(&ring->head, memory_order_acquire)) {
+        deferred_log_record_t *rec = &ring->records[tail & (DEFERRED_LOG_CAPACITY - 1)];
+        const char *fmt = atomic_load_explicit(&rec->fmt, memory_order_acquire);
+        if (fmt == NULL) {
+            break;
+        }
+        uint32_t cycles = rec->cycles, a0 = rec->args[0], a1 = rec->args[1], a2 = rec->args[2];
+        atomic_store_explicit(&rec->fmt, NULL, memory_order_relaxed);
+        atomic_store_explicit(&ring->tail, ++tail, memory_order_release);
+
+        // the cycle counters of the two cores aren't in sync, so only deltas within a core mean anything
+        printf("[c%d +%lu us] ", core, (unsigned long)((cycles - ring->last_cycles) / ticks_per_us));
+        printf(fmt, a0, a1, a2);
+        putchar('\n');
+        ring->last_cycles = cycles;
+    }
+
+    uint32_t dropped = deferred_log_dropped(core);
+    if (dropped != ring->reported_drops) {
+        printf("deferred log: %lu records dropped on core %d\n", (unsigned long)dropped, core);
+        ring->reported_drops = dropped;
+    }
+}
+
+void deferred_log_flush(void)
+{
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        drain_ring(core);
+    }
+}
+
+static void drain_task(void *arg)
+{
+    while (1) {
+        deferred_log_flush();
+        vTaskDelay(drain_period_ticks);
+    }
+}
+
+void deferred_log_init(uint32_t drain_priority, uint32_t drain_period_ms)
+{
+    drain_period_ticks = pdMS_TO_TICKS(drain_period_ms) > 0 ? pdMS_TO_TICKS(drain_period_ms) : 1;
+    xTaskCreate(drain_task, "dlog_drain", 3072, NULL, drain_priority, NULL);
+}
@@ -0,0 +1,51 @@
+/*
+    Deferred binary logging for ESP32 hot paths.
+
+    DLOG(fmt, args...) doesn't format anything: it stores the format string pointer, the CPU cycle counter and up
+    to three 32-bit arguments as one 20-byte record in a ring of the core it runs on, a compare-and-swap to claim
+    the slot and five stores. A low-priority drain task started by deferred_log_init() pops the records later and
+    does the printf, with the time since the previous record of the same core.
+
+    Rules that come from not formatting on the spot:
+        - fmt must be a string literal (only its address is stored)
+        - arguments are 32-bit integers: %d %u %x %c, and %s only with string literals ("ON" : "OFF")
+        - at least one argument, pass 0 if the message has none
+
+    When a ring is full the record is dropped and counted, the caller never waits. The drain task prints the
+    drop counts whenever they change. DLOG is IRAM-resident and takes no lock, so it can be used from ISRs.
+    Tasks migrating between cores only share a ring for that record, the rings are safe for several producers.
+
+    deferred_log.c has to be built into the component of the demo that uses it (ESP32/C++/CMakeLists.txt does
+    this already), e.g. for a component in ESP32/SPI:
+        idf_component_register(
+            SRCS "spi_slave_mode_0_16bit.c" "../Common/deferred_log.c"
+            INCLUDE_DIRS "."
+            REQUIRES esp_driver_spi esp_driver_gpio esp_timer freertos esp_hw_support esp_rom
+        )
+    deferred_log.c itself needs freertos, esp_hw_support (esp_cpu.h, core id and cycle counter) and esp_rom
+    (CPU ticks per microsecond).
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEFERRED_LOG_CAPACITY 256      // records per core, power of two
+
+void deferred_log_init(uint32_t drain_priority, uint32_t drain_period_ms);
+void deferred_log_write(const char *fmt, uint32_t a0, uint32_t a1, uint32_t a2);
+uint32_t deferred_log_dropped(int core);
+
+// Formats and prints everything queued so far on the calling task, e.g. before a restart
+void deferred_log_flush(void);
+
+#define DLOG_ARGS_(a0, a1, a2, ...) (uint32_t)(uintptr_t)(a0), (uint32_t)(uintptr_t)(a1), (uint32_t)(uintptr_t)(a2)
+#define DLOG(fmt, ...) deferred_log_write((fmt), DLOG_ARGS_(__VA_ARGS__, 0, 0, 0))
+
+#ifdef __cplusplus
+}
+#endif
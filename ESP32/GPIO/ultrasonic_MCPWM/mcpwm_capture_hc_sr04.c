@@ -4,11 +4,33 @@
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
 
+/*
+ * Up to three HC-SR04 sensors on the three capture channels of one MCPWM capture timer. Each channel has its own
+ * hc_sr04_sensor_t, passed to the capture callback as user_data, so the edge timestamps of one sensor never mix
+ * with another's. Completed measurements from all sensors go into one queue, tagged with the sensor id.
+ *
+ * HC_SR04_HW_TRIGGER 1: one MCPWM timer (1 MHz, HC_SR04_PERIOD_US period) and one operator per sensor put the
+ * 10 us trigger pulses on the Trig pins by themselves, 60 ms per sensor being the measurement cycle the datasheet
+ * asks for. The pulses are staggered by a third of the period (20 ms with three sensors), which only spreads the
+ * load: an HC-SR04 holds Echo high for up to ~38 ms when nothing answers, so a sensor can still hear the burst of
+ * the one fired 20 ms before it when they point the same way. Point them in different directions; spacing three
+ * triggers at least 38 ms apart would need a period of 114 ms, beyond the 16-bit timer.
+ * The task only wakes up per completed measurement and prints the latest distances and the measurement rate
+ * (per sensor and in total, ~50/s with three sensors) once a second.
+ *
+ * HC_SR04_HW_TRIGGER 0: the original software trigger, gpio_set_level + esp_rom_delay_us(10), one sensor after
+ * the other with 500 ms / HC_SR04_NUM_SENSORS in between.
+ */
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
 #include "esp_private/esp_clk.h"
 #include "driver/mcpwm_cap.h"
+#include "driver/mcpwm_prelude.h"
 #include "driver/gpio.h"
 
 const static char *TAG = "example";
@@ -16,42 +38,127 @@ const static char *TAG = "example";
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// Please update the following configuration according to your board spec ////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-#define HC_SR04_TRIG_GPIO  1
-#define HC_SR04_ECHO_GPIO  2
+#define HC_SR04_NUM_SENSORS  3          // 1 to 3, one capture channel each
+static const int hc_sr04_trig_gpio[] = {1, 4, 6};
+static const int hc_sr04_echo_gpio[] = {2, 5, 7};
+
+#define HC_SR04_HW_TRIGGER     1
+#define HC_SR04_PERIOD_US      60000    // trigger to trigger per sensor, at most 65535 (16-bit MCPWM timer at 1 MHz)
+#define HC_SR04_TRIG_WIDTH_US  10
+#define HC_SR04_QUEUE_LENGTH   32
+
+_Static_assert(HC_SR04_NUM_SENSORS >= 1 && HC_SR04_NUM_SENSORS <= 3, "a capture timer has three channels");
+_Static_assert(sizeof(hc_sr04_trig_gpio) / sizeof(hc_sr04_trig_gpio[0]) >= HC_SR04_NUM_SENSORS, "Trig pins");
+_Static_assert(sizeof(hc_sr04_echo_gpio) / sizeof(hc_sr04_echo_gpio[0]) >= HC_SR04_NUM_SENSORS, "Echo pins");
+
+// one completed echo, queued by the capture ISR
+typedef struct {
+    int64_t time_us;        // esp_timer time of the falling echo edge
+    uint32_t tof_ticks;     // echo pulse width in capture timer ticks (APB clock)
+    uint8_t sensor_id;
+} hc_sr04_measurement_t;
+
+// per capture channel, only the ISR of that channel writes it
+typedef struct {
+    uint8_t id;
+    QueueHandle_t measurements;
+    uint32_t cap_val_begin_of_sample;
+    bool echo_high;
+    mcpwm_cap_channel_handle_t cap_chan;
+} hc_sr04_sensor_t;
+
+static hc_sr04_sensor_t sensors[HC_SR04_NUM_SENSORS];
 
 static bool hc_sr04_echo_callback(mcpwm_cap_channel_handle_t cap_chan, const mcpwm_capture_event_data_t *edata, void *user_data)
 {
-    static uint32_t cap_val_begin_of_sample = 0;
-    static uint32_t cap_val_end_of_sample = 0;
-    TaskHandle_t task_to_notify = (TaskHandle_t)user_data;
+    hc_sr04_sensor_t *sensor = (hc_sr04_sensor_t *)user_data;
     BaseType_t high_task_wakeup = pdFALSE;
 
     //calculate the interval in the ISR,
     //so that the interval will be always correct even when capture_queue is not handled in time and overflow.
     if (edata->cap_edge == MCPWM_CAP_EDGE_POS) {
         // store the timestamp when pos edge is detected
-        cap_val_begin_of_sample = edata->cap_value;
-        cap_val_end_of_sample = cap_val_begin_of_sample;
-    } else {
-        cap_val_end_of_sample = edata->cap_value;
-        uint32_t tof_ticks = cap_val_end_of_sample - cap_val_begin_of_sample;
-
-        // notify the task to calculate the distance
-        xTaskNotifyFromISR(task_to_notify, tof_ticks, eSetValueWithOverwrite, &high_task_wakeup);
+        sensor->cap_val_begin_of_sample = edata->cap_value;
+        sensor->echo_high = true;
+    } else if (sensor->echo_high) {
+        uint32_t tof_ticks = edata->cap_value - sensor->cap_val_begin_of_sample;
+        sensor->echo_high = false;
+
+        // hand the measurement to the task, dropped if the task is that far behind
+        hc_sr04_measurement_t m = {
+            .time_us = esp_timer_get_time(),
+            .tof_ticks = tof_ticks,
+            .sensor_id = sensor->id,
+        };
+        xQueueSendFromISR(sensor->measurements, &m, &high_task_wakeup);
     }
 
     return high_task_wakeup == pdTRUE;
 }
 
+#if HC_SR04_HW_TRIGGER
+/**
+ * @brief periodic trigger pulses from MCPWM group 0: one timer, one operator per sensor, the generator of sensor
+ *        i goes high at the first comparator (i * period / N) and low at the second, 10 us later
+ */
+static void start_trig_generators(void)
+{
+    mcpwm_timer_handle_t timer = NULL;
+    mcpwm_timer_config_t timer_conf = {
+        .group_id = 0,
+        .clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT,
+        .resolution_hz = 1000000,   // 1 tick = 1 us
+        .count_mode = MCPWM_TIMER_COUNT_MODE_UP,
+        .period_ticks = HC_SR04_PERIOD_US,
+    };
+    ESP_ERROR_CHECK(mcpwm_new_timer(&timer_conf, &timer));
+
+    for (int i = 0; i < HC_SR04_NUM_SENSORS; i++) {
+        mcpwm_oper_handle_t oper = NULL;
+        mcpwm_operator_config_t oper_conf = {
+            .group_id = 0,
+        };
+        ESP_ERROR_CHECK(mcpwm_new_operator(&oper_conf, &oper));
+        ESP_ERROR_CHECK(mcpwm_operator_connect_timer(oper, timer));
+
+        // start a few ticks after zero so that the first sensor also switches on a compare event; the stagger is
+        // shorter than a timed-out echo (~38 ms), see the crosstalk note at the top
+        uint32_t rise = HC_SR04_TRIG_WIDTH_US + i * (HC_SR04_PERIOD_US / HC_SR04_NUM_SENSORS);
+        mcpwm_cmpr_handle_t cmpr_rise = NULL;
+        mcpwm_cmpr_handle_t cmpr_fall = NULL;
+        mcpwm_comparator_config_t cmpr_conf = {
+            .flags.update_cmp_on_tez = true,
+        };
+        ESP_ERROR_CHECK(mcpwm_new_comparator(oper, &cmpr_conf, &cmpr_rise));
+        ESP_ERROR_CHECK(mcpwm_new_comparator(oper, &cmpr_conf, &cmpr_fall));
+        ESP_ERROR_CHECK(mcpwm_comparator_set_compare_value(cmpr_rise, rise));
+        ESP_ERROR_CHECK(mcpwm_comparator_set_compare_value(cmpr_fall, rise + HC_SR04_TRIG_WIDTH_US));
+
+        mcpwm_gen_handle_t gen = NULL;
+        mcpwm_generator_config_t gen_conf = {
+            .gen_gpio_num = hc_sr04_trig_gpio[i],
+        };
+        ESP_ERROR_CHECK(mcpwm_new_generator(oper, &gen_conf, &gen));
+        ESP_ERROR_CHECK(mcpwm_generator_set_action_on_compare_event(gen,
+            MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, cmpr_rise, MCPWM_GEN_ACTION_HIGH)));
+        ESP_ERROR_CHECK(mcpwm_generator_set_action_on_compare_event(gen,
+            MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, cmpr_fall, MCPWM_GEN_ACTION_LOW)));
+    }
+
+    ESP_ERROR_CHECK(mcpwm_timer_enable(timer));
+    ESP_ERROR_CHECK(mcpwm_timer_start_stop(timer, MCPWM_TIMER_START_NO_STOP));
+}
+#else
 /**
  * @brief generate single pulse on Trig pin to start a new sample
  */
-static void gen_trig_output(void)
+static void gen_trig_output(int trig_gpio)
 {
-    gpio_set_level(HC_SR04_TRIG_GPIO, 1); // set high
-    esp_rom_delay_us(10);
-    gpio_set_level(HC_SR04_TRIG_GPIO, 0); // set low
+    gpio_set_level(trig_gpio, 1); // set high
+    esp_rom_delay_us(HC_SR04_TRIG_WIDTH_US);
+    gpio_set_level(trig_gpio, 0); // set low
 }
+#endif
 
 void app_main(void)
 {
@@ -63,57 +170,102 @@ void app_main(void)
     };
     ESP_ERROR_CHECK(mcpwm_new_capture_timer(&cap_conf, &cap_timer));
 
-    ESP_LOGI(TAG, "Install capture channel");
-    mcpwm_cap_channel_handle_t cap_chan = NULL;
-    mcpwm_capture_channel_config_t cap_ch_conf = {
-        .gpio_num = HC_SR04_ECHO_GPIO,
-        .prescale = 1,
-        // capture on both edge
-        .flags.neg_edge = true,
-        .flags.pos_edge = true,
-        // pull up internally
-        .flags.pull_up = true,
-    };
-    ESP_ERROR_CHECK(mcpwm_new_capture_channel(cap_timer, &cap_ch_conf, &cap_chan));
+    QueueHandle_t measurements = xQueueCreate(HC_SR04_QUEUE_LENGTH, sizeof(hc_sr04_measurement_t));
 
-    ESP_LOGI(TAG, "Register capture callback");
-    TaskHandle_t cur_task = xTaskGetCurrentTaskHandle();
-    mcpwm_capture_event_callbacks_t cbs = {
-        .on_cap = hc_sr04_echo_callback,
-    };
-    ESP_ERROR_CHECK(mcpwm_capture_channel_register_event_callbacks(cap_chan, &cbs, cur_task));
+    for (int i = 0; i < HC_SR04_NUM_SENSORS; i++) {
+        ESP_LOGI(TAG, "Install capture channel %d (Echo GPIO%d)", i, hc_sr04_echo_gpio[i]);
+        hc_sr04_sensor_t *sensor = &sensors[i];
+        sensor->id = i;
+        sensor->measurements = measurements;
+        mcpwm_capture_channel_config_t cap_ch_conf = {
+            .gpio_num = hc_sr04_echo_gpio[i],
+            .prescale = 1,
+            // capture on both edge
+            .flags.neg_edge = true,
+            .flags.pos_edge = true,
+            // pull up internally
+            .flags.pull_up = true,
+        };
+        ESP_ERROR_CHECK(mcpwm_new_capture_channel(cap_timer, &cap_ch_conf, &sensor->cap_chan));
 
-    ESP_LOGI(TAG, "Enable capture channel");
-    ESP_ERROR_CHECK(mcpwm_capture_channel_enable(cap_chan));
+        // the channel's own state is the callback argument
+        mcpwm_capture_event_callbacks_t cbs = {
+            .on_cap = hc_sr04_echo_callback,
+        };
+        ESP_ERROR_CHECK(mcpwm_capture_channel_register_event_callbacks(sensor->cap_chan, &cbs, sensor));
+        ESP_ERROR_CHECK(mcpwm_capture_channel_enable(sensor->cap_chan));
+    }
+
+    ESP_LOGI(TAG, "Enable and start capture timer");
+    ESP_ERROR_CHECK(mcpwm_capture_timer_enable(cap_timer));
+    ESP_ERROR_CHECK(mcpwm_capture_timer_start(cap_timer));
 
-    ESP_LOGI(TAG, "Configure Trig pin");
+#if HC_SR04_HW_TRIGGER
+    ESP_LOGI(TAG, "Start MCPWM triggers, %d us pulse every %d us per sensor, %d sensors staggered",
+             HC_SR04_TRIG_WIDTH_US, HC_SR04_PERIOD_US, HC_SR04_NUM_SENSORS);
+    start_trig_generators();
+#else
+    ESP_LOGI(TAG, "Configure Trig pins");
+    uint64_t trig_mask = 0;
+    for (int i = 0; i < HC_SR04_NUM_SENSORS; i++) {
+        trig_mask |= 1ULL << hc_sr04_trig_gpio[i];
+    }
     gpio_config_t io_conf = {
         .mode = GPIO_MODE_OUTPUT,
-        .pin_bit_mask = 1ULL << HC_SR04_TRIG_GPIO,
+        .pin_bit_mask = trig_mask,
     };
     ESP_ERROR_CHECK(gpio_config(&io_conf));
     // drive low by default
-    ESP_ERROR_CHECK(gpio_set_level(HC_SR04_TRIG_GPIO, 0));
+    for (int i = 0; i < HC_SR04_NUM_SENSORS; i++) {
+        ESP_ERROR_CHECK(gpio_set_level(hc_sr04_trig_gpio[i], 0));
+    }
+    int next_sensor = 0;
+#endif
 
-    ESP_LOGI(TAG, "Enable and start capture timer");
-    ESP_ERROR_CHECK(mcpwm_capture_timer_enable(cap_timer));
-    ESP_ERROR_CHECK(mcpwm_capture_timer_start(cap_timer));
+    const float us_per_tick = 1000000.0f / esp_clk_apb_freq();
+    float distance_cm[HC_SR04_NUM_SENSORS] = {0};
+    uint32_t count[HC_SR04_NUM_SENSORS] = {0};
+    uint32_t out_of_range[HC_SR04_NUM_SENSORS] = {0};
+    int64_t report_start_us = esp_timer_get_time();
+    hc_sr04_measurement_t m;
 
-    uint32_t tof_ticks;
     while (1) {
-        // trigger the sensor to start a new sample
-        gen_trig_output();
+#if !HC_SR04_HW_TRIGGER
+        // trigger the next sensor to start a new sample
+        gen_trig_output(hc_sr04_trig_gpio[next_sensor]);
+        next_sensor = (next_sensor + 1) % HC_SR04_NUM_SENSORS;
+#endif
         // wait for echo done signal
-        if (xTaskNotifyWait(0x00, ULONG_MAX, &tof_ticks, pdMS_TO_TICKS(1000)) == pdTRUE) {
-            float pulse_width_us = tof_ticks * (1000000.0 / esp_clk_apb_freq());
+        if (xQueueReceive(measurements, &m, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            float pulse_width_us = m.tof_ticks * us_per_tick;
+            count[m.sensor_id]++;
             if (pulse_width_us > 35000) {
                 // out of range
-                continue;
+                out_of_range[m.sensor_id]++;
+            } else {
+                // convert the pulse width into measure distance
+                distance_cm[m.sensor_id] = pulse_width_us / 58;
+            }
+        } else {
+            ESP_LOGW(TAG, "No echo for 1 s");
+        }
+
+        int64_t now_us = esp_timer_get_time();
+        if (now_us - report_start_us >= 1000000) {
+            float seconds = (now_us - report_start_us) / 1e6f;
+            uint32_t total = 0;
+            for (int i = 0; i < HC_SR04_NUM_SENSORS; i++) {
+                ESP_LOGI(TAG, "sensor %d: %.2fcm, %.1f/s, %lu out of range", i, distance_cm[i], count[i] / seconds,
+                         (unsigned long)out_of_range[i]);
+                total += count[i];
+                count[i] = 0;
+                out_of_range[i] = 0;
             }
-            // convert the pulse width into measure distance
-            float distance = (float) pulse_width_us / 58;
-            ESP_LOGI(TAG, "Measured distance: %.2fcm", distance);
+            ESP_LOGI(TAG, "all sensors: %.1f measurements/s", total / seconds);
+            report_start_us = now_us;
         }
-        vTaskDelay(pdMS_TO_TICKS(500));
+#if !HC_SR04_HW_TRIGGER
+        vTaskDelay(pdMS_TO_TICKS(500 / HC_SR04_NUM_SENSORS));
+#endif
     }
 }
@@ -0,0 +1,158 @@
+#include "spi_dma_rx.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#define TAG "SPI_DMA_RX"
+#define SPI_DMA_RX_POOL (SPI_DMA_RX_QUEUE_DEPTH + SPI_DMA_RX_SPARES)
+
+static spi_dma_rx_frame_t frames[SPI_DMA_RX_POOL];
+static spi_host_device_t rx_host;
+static size_t rx_buffer_size;
+static QueueHandle_t free_queue;        // spare frames, released by the consumer
+static QueueHandle_t filled_queue;      // completed frames for the consumer
+static uint32_t completed;              // receiver task only
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static spi_dma_rx_stats_t stats;
+
+// Completion interrupt, only stamps the time
+static void IRAM_ATTR on_trans_done(spi_slave_transaction_t *trans)
+{
+    ((spi_dma_rx_frame_t *)trans->user)->time_us = esp_timer_get_time();
+}
+
+static void post(spi_dma_rx_frame_t *frame)
+{
+    frame->trans.length = rx_buffer_size * 8;
+    frame->trans.trans_len = 0;
+    frame->trans.rx_buffer = frame->data;
+    frame->trans.tx_buffer = NULL;
+    frame->trans.user = frame;
+    ESP_ERROR_CHECK(spi_slave_queue_trans(rx_host, &frame->trans, portMAX_DELAY));
+}
+
+static void receiver_task(void *arg)
+{
+    while (1) {
+        spi_slave_transaction_t *done;
+        if (spi_slave_get_trans_result(rx_host, &done, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+        spi_dma_rx_frame_t *frame = (spi_dma_rx_frame_t *)done->user;
+        frame->length = done->trans_len / 8;
+        frame->index = completed++;
+
+        // keep the driver's queue full before anything else
+        spi_dma_rx_frame_t *spare;
+        bool delivered = xQueueReceive(free_queue, &spare, 0) == pdTRUE;
+        post(delivered ? spare : frame);
+
+        taskENTER_CRITICAL(&stats_lock);
+        if (stats.frames == 0) {
+            stats.first_us = frame->time_us;
+        } else {
+            stats.bytes += frame->length;
+        }
+        stats.last_us = frame->time_us;
+        stats.frames++;
+        if (frame->length < rx_buffer_size) {
+            stats.short_frames++;
+        }
+        if (delivered) {
+            stats.delivered++;
+        } else {
+            stats.dropped++;
+        }
+        taskEXIT_CRITICAL(&stats_lock);
+
+        if (delivered) {
+            // room for the whole pool, never fails
+            xQueueSend(filled_queue, &frame, 0);
+        }
+    }
+}
+
+esp_err_t spi_dma_rx_start(const spi_dma_rx_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(config->buffer_size > 0 && config->buffer_size % 4 == 0, ESP_ERR_INVALID_ARG, TAG,
+                        "buffer_size must be a multiple of 4");
+    rx_host = config->host;
+    rx_buffer_size = config->buffer_size;
+    stats.master_clock_hz = config->master_clock_hz;
+
+    spi_bus_config_t buscfg = {
+        .mosi_io_num = config->mosi_io_num,
+        .miso_io_num = -1,  // receive only
+        .sclk_io_num = config->sclk_io_num,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = (int)config->buffer_size
+    };
+
+    spi_slave_interface_config_t slvcfg = {
+        .mode = config->mode,
+        .spics_io_num = config->cs_io_num,
+        .queue_size = SPI_DMA_RX_QUEUE_DEPTH,
+        .flags = 0,
+        .post_setup_cb = NULL,
+        .post_trans_cb = on_trans_done
+    };
+
+    ESP_RETURN_ON_ERROR(spi_slave_initialize(rx_host, &buscfg, &slvcfg, SPI_DMA_CH_AUTO), TAG, "slave init");
+
+    free_queue = xQueueCreate(SPI_DMA_RX_POOL, sizeof(spi_dma_rx_frame_t *));
+    filled_queue = xQueueCreate(SPI_DMA_RX_POOL, sizeof(spi_dma_rx_frame_t *));
+    ESP_RETURN_ON_FALSE(free_queue && filled_queue, ESP_ERR_NO_MEM, TAG, "queues");
+
+    for (int i = 0; i < SPI_DMA_RX_POOL; i++) {
+        memset(&frames[i], 0, sizeof(frames[i]));
+        frames[i].data = heap_caps_aligned_alloc(4, config->buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_RETURN_ON_FALSE(frames[i].data, ESP_ERR_NO_MEM, TAG, "DMA buffer %d", i);
+        if (i < SPI_DMA_RX_QUEUE_DEPTH) {
+            post(&frames[i]);
+        } else {
+            spi_dma_rx_frame_t *spare = &frames[i];
+            xQueueSend(free_queue, &spare, 0);
+        }
+    }
+
+    ESP_LOGI(TAG, "%d x %u bytes posted, %d spares", SPI_DMA_RX_QUEUE_DEPTH, (unsigned)config->buffer_size,
+             SPI_DMA_RX_SPARES);
+    BaseType_t ok = xTaskCreate(receiver_task, "spi_dma_rx", 3072, NULL, config->task_priority, NULL);
+    return ok == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+bool spi_dma_rx_receive(spi_dma_rx_frame_t **frame, TickType_t wait)
+{
+    return xQueueReceive(filled_queue, frame, wait) == pdTRUE;
+}
+
+void spi_dma_rx_release(spi_dma_rx_frame_t *frame)
+{
+    xQueueSend(free_queue, &frame, 0);
+}
+
+void spi_dma_rx_get_stats(spi_dma_rx_stats_t *out)
+{
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+void spi_dma_rx_print_stats(const spi_dma_rx_stats_t *s)
+{
+    int64_t span_us = s->last_us - s->first_us;
+    double bits_per_s = span_us > 0 ? s->bytes * 8.0 * 1e6 / span_us : 0;
+    double share = s->master_clock_hz ? 100.0 * bits_per_s / s->master_clock_hz : 0;
+    printf("SPI RX: %lu frames, %lu delivered, %lu dropped, %lu short, %.2f Mbit/s = %.1f%% of the %.2f MHz clock\n",
+           (unsigned long)s->frames, (unsigned long)s->delivered, (unsigned long)s->dropped,
+           (unsigned long)s->short_frames, bits_per_s / 1e6, share, s->master_clock_hz / 1e6);
+}
@@ -0,0 +1,86 @@
+/*
+    DMA SPI slave receiver that always has transactions posted.
+
+    spi_slave_mode_0_16bit.c posts one 2-byte transaction, waits for it and logs it, so the bus sits idle between
+    words and anything the master clocks out meanwhile is lost. Here the driver gets SPI_DMA_RX_QUEUE_DEPTH
+    transactions of buffer_size bytes up front, in DMA-capable memory, and a receiver task re-posts a spare buffer
+    the moment one completes. The hardware always has the next buffer queued while the current one fills.
+
+    Completed buffers go to the consumer as pointers through a FreeRTOS queue, nothing is copied:
+
+        spi_dma_rx_frame_t *frame;
+        while (spi_dma_rx_receive(&frame, portMAX_DELAY)) {
+            ... frame->data, frame->length ...
+            spi_dma_rx_release(frame);
+        }
+
+    The consumer may hold up to SPI_DMA_RX_SPARES frames at a time. When it falls further behind there is no spare
+    to re-post, the receiver then posts the completed buffer again instead and its data is lost; that is counted
+    as a dropped frame, the queue depth stays full either way.
+
+    ESP32 slave DMA restrictions: buffer_size must be a multiple of 4 and the master should send whole words,
+    a frame shorter than buffer_size (chip select released early) is delivered with its actual length and counted
+    as short. master_clock_hz is only used to put the throughput in relation to the bus rate.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "driver/spi_slave.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPI_DMA_RX_QUEUE_DEPTH 3        // transactions posted to the driver at all times (triple buffering)
+#define SPI_DMA_RX_SPARES      3        // buffers the consumer can hold before frames are dropped
+
+typedef struct {
+    spi_host_device_t host;
+    int mosi_io_num;
+    int sclk_io_num;
+    int cs_io_num;
+    uint8_t mode;
+    size_t buffer_size;                 // bytes per transaction, multiple of 4
+    uint32_t master_clock_hz;
+    UBaseType_t task_priority;          // receiver task, above the consumer
+} spi_dma_rx_config_t;
+
+typedef struct {
+    uint8_t *data;
+    size_t length;                      // bytes actually received
+    uint32_t index;                     // completion count, consecutive unless frames were dropped
+    int64_t time_us;                    // esp_timer time of the completion interrupt
+    spi_slave_transaction_t trans;      // driver side, trans.user points back to the frame
+} spi_dma_rx_frame_t;
+
+typedef struct {
+    uint32_t frames;                    // completed transactions
+    uint32_t delivered;                 // handed to the consumer
+    uint32_t dropped;                   // completed while the consumer held every spare
+    uint32_t short_frames;              // chip select released before buffer_size bytes
+    uint64_t bytes;                     // received after the first frame (dropped ones too), first_us..last_us
+    int64_t first_us;                   // completion time of the first and the last frame
+    int64_t last_us;
+    uint32_t master_clock_hz;
+} spi_dma_rx_stats_t;
+
+esp_err_t spi_dma_rx_start(const spi_dma_rx_config_t *config);
+
+// Next completed frame, false after wait ticks without one
+bool spi_dma_rx_receive(spi_dma_rx_frame_t **frame, TickType_t wait);
+
+// Gives the buffer back for re-posting, the frame must not be touched afterwards
+void spi_dma_rx_release(spi_dma_rx_frame_t *frame);
+
+void spi_dma_rx_get_stats(spi_dma_rx_stats_t *stats);
+
+// Throughput from first to last frame and the share of the master's clock rate it reaches
+void spi_dma_rx_print_stats(const spi_dma_rx_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
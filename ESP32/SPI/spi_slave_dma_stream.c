@@ -0,0 +1,82 @@
+/*
+    Receive side of a continuous SPI stream, on top of spi_dma_rx.c.
+
+    The master (Raspberry Pi/Experiemental Projects/SPI ESP32 slave/spi_stream_master.cpp) sends frames of
+    FRAME_BYTES with a 32-bit little-endian frame counter in the first four bytes. The consumer task checks the
+    counter for gaps and sums the payload, standing in for real work, then releases the buffer. Every second the
+    receiver statistics are printed: throughput against MASTER_CLOCK_HZ, frames dropped here because the consumer
+    held every spare, and counter gaps, which also include frames the slave never saw (no transaction posted).
+
+    Use the same clock and frame size on both sides: ./spi_stream_master 8000000 4096
+*/
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spi_dma_rx.h"
+
+// Define GPIO pins for SPI
+#define PIN_NUM_MOSI 6   // Use GPIO6 for MOSI
+#define PIN_NUM_CLK  18  // Use GPIO18 for SCLK
+#define PIN_NUM_CS   5   // Use GPIO5 for CS
+
+#define FRAME_BYTES     4096
+#define MASTER_CLOCK_HZ 8000000
+
+static _Atomic uint32_t missing_frames;
+static _Atomic uint32_t checksum;
+
+static void consumer_task(void *arg)
+{
+    uint32_t expected = 0;
+    bool first = true;
+    spi_dma_rx_frame_t *frame;
+
+    while (spi_dma_rx_receive(&frame, portMAX_DELAY)) {
+        if (frame->length >= 4) {
+            const uint8_t *d = frame->data;
+            uint32_t counter = d[0] | (d[1] << 8) | (d[2] << 16) | ((uint32_t)d[3] << 24);
+            if (!first && counter != expected) {
+                atomic_fetch_add_explicit(&missing_frames, counter - expected, memory_order_relaxed);
+            }
+            expected = counter + 1;
+            first = false;
+        }
+
+        uint32_t sum = 0;
+        const uint32_t *words = (const uint32_t *)frame->data;
+        for (size_t i = 0; i < frame->length / 4; i++) {
+            sum += words[i];
+        }
+        atomic_store_explicit(&checksum, sum, memory_order_relaxed);
+
+        spi_dma_rx_release(frame);
+    }
+}
+
+void app_main(void)
+{
+    spi_dma_rx_config_t config = {
+        .host = SPI2_HOST,
+        .mosi_io_num = PIN_NUM_MOSI,
+        .sclk_io_num = PIN_NUM_CLK,
+        .cs_io_num = PIN_NUM_CS,
+        .mode = 0,
+        .buffer_size = FRAME_BYTES,
+        .master_clock_hz = MASTER_CLOCK_HZ,
+        .task_priority = 10
+    };
+    ESP_ERROR_CHECK(spi_dma_rx_start(&config));
+
+    xTaskCreate(consumer_task, "spi_consumer", 3072, NULL, 5, NULL);
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        spi_dma_rx_stats_t stats;
+        spi_dma_rx_get_stats(&stats);
+        spi_dma_rx_print_stats(&stats);
+        printf("        %lu frames missing from the master's counter, last checksum %08lx\n",
+               (unsigned long)atomic_load(&missing_frames), (unsigned long)atomic_load(&checksum));
+    }
+}
@@ -0,0 +1,105 @@
+/*
+    ESP32 end of the framed SPI stream: spi_dma_rx.c receives the transactions with DMA, the consumer task checks
+    and unpacks the frames with Shared/spi_frame.hpp.
+
+    The master is Raspberry Pi/Experiemental Projects/SPI ESP32 slave/spi_frame_master.cpp. Sample frames are
+    counted and their last value kept, command opcode 1 switches the LED on GPIO23. Every second the link
+    statistics are printed: good frames, CRC and header errors (a command frame too short for opcode and value
+    counts as one), frames missing from the sequence, the samples per second that arrived and the DMA receiver's
+    own numbers.
+*/
+
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spi_dma_rx.h"
+}
+
+#include "../../Shared/spi_frame.hpp"
+#include "../C++/gpio_out.hpp"
+
+// Define GPIO pins for SPI
+#define PIN_NUM_MOSI 6   // Use GPIO6 for MOSI
+#define PIN_NUM_CLK  18  // Use GPIO18 for SCLK
+#define PIN_NUM_CS   5   // Use GPIO5 for CS
+
+static constexpr size_t TRANSACTION_BYTES = 4096;  // the master's transactionBytes
+static constexpr uint32_t MASTER_CLOCK_HZ = 8000000;
+static constexpr uint8_t CMD_LED = 1;
+
+using Led = GpioOut<GPIO_NUM_23>;
+
+static SpiFrameReceiver receiver;                   // consumer task only
+static std::atomic<uint32_t> samples_received{0};
+static std::atomic<uint32_t> last_sample{0};
+
+// snapshot of the receiver statistics for app_main
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static SpiFrameStats link_stats;
+
+static void consumer_task(void *arg)
+{
+    spi_dma_rx_frame_t *buffer;
+    while (spi_dma_rx_receive(&buffer, portMAX_DELAY)) {
+        receiver.process(buffer->data, buffer->length, [](const SpiFrame &frame) {
+            if (frame.header.type == SpiFrameType::Samples) {
+                size_t n = frame.sampleCount();
+                if (n > 0) {
+                    last_sample.store(frame.sample(n - 1), std::memory_order_relaxed);
+                }
+                samples_received.fetch_add(n, std::memory_order_relaxed);
+            } else if (frame.header.type == SpiFrameType::Command && frame.opcode() == CMD_LED) {
+                // the receiver only passes on command frames of at least commandSize bytes
+                Led::write(frame.value() != 0);
+            }
+        });
+        spi_dma_rx_release(buffer);
+
+        taskENTER_CRITICAL(&stats_lock);
+        link_stats = receiver.stats();
+        taskEXIT_CRITICAL(&stats_lock);
+    }
+}
+
+extern "C" void app_main(void)
+{
+    Led::configure(false);
+
+    spi_dma_rx_config_t config = {};
+    config.host = SPI2_HOST;
+    config.mosi_io_num = PIN_NUM_MOSI;
+    config.sclk_io_num = PIN_NUM_CLK;
+    config.cs_io_num = PIN_NUM_CS;
+    config.mode = 0;
+    config.buffer_size = TRANSACTION_BYTES;
+    config.master_clock_hz = MASTER_CLOCK_HZ;
+    config.task_priority = 10;
+    ESP_ERROR_CHECK(spi_dma_rx_start(&config));
+
+    xTaskCreate(consumer_task, "spi_frames", 4096, nullptr, 5, nullptr);
+
+    uint32_t last_samples = 0;
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+
+        SpiFrameStats s;
+        taskENTER_CRITICAL(&stats_lock);
+        s = link_stats;
+        taskEXIT_CRITICAL(&stats_lock);
+        uint32_t samples = samples_received.load(std::memory_order_relaxed);
+
+        printf("frames %llu, crc errors %llu, header errors %llu, lost %llu, %lu samples/s, last %lu, LED %s\n",
+               (unsigned long long)s.frames, (unsigned long long)s.crcErrors, (unsigned long long)s.headerErrors,
+               (unsigned long long)s.lostFrames, (unsigned long)(samples - last_samples),
+               (unsigned long)last_sample.load(std::memory_order_relaxed), Led::get() ? "on" : "off");
+        last_samples = samples;
+
+        spi_dma_rx_stats_t rx;
+        spi_dma_rx_get_stats(&rx);
+        spi_dma_rx_print_stats(&rx);
+    }
+}
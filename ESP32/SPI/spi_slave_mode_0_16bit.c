@@ -7,6 +7,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_timer.h"  // For esp_timer_get_time
+#include "../Common/deferred_log.h"
 
 #define TAG "SPI_SLAVE"
 
@@ -36,6 +37,9 @@ void app_main(void) {
         .post_trans_cb = NULL
     };
 
+    // Received values are printed by a low-priority task, the loop only queues a 20-byte record
+    deferred_log_init(1, 50);
+
     // Initialize SPI slave interface
     ESP_ERROR_CHECK(spi_slave_initialize(SPI2_HOST, &buscfg, &slvcfg, SPI_DMA_DISABLED));
 
@@ -56,6 +60,6 @@ void app_main(void) {
         uint16_t received_value = (recvbuf[0] << 8) | recvbuf[1];
       
         // Log the received decimal value
-        ESP_LOGI(TAG, "Received decimal value: %u", received_value);
+        DLOG("Received decimal value: %u", received_value);
     }
 }
\ No newline at end of file
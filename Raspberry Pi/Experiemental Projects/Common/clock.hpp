@@ -0,0 +1,123 @@
+/*
+    Clock policies for timing code that should also run in simulation.
+
+    Timing components take the clock as a template parameter and only call Clock::now(), Clock::sleepFor() and
+    Clock::sleepUntil(), all static. With SteadyClock those are direct calls into std::chrono / std::this_thread that
+    the compiler inlines, so production builds pay nothing for the indirection.
+
+    VirtualClock is a single-threaded discrete-event clock: time only moves when the code under test sleeps,
+    and it jumps straight to the deadline. Callbacks scheduled with VirtualClock::at() run when simulated time
+    reaches them (e.g. an echo edge arriving 1.2 ms after a trigger). It also counts deadlines that were already
+    in the past when sleepUntil() was called, which is how a test checks a loop kept to its schedule.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <queue>
+#include <vector>
+#include <cstdint>
+
+struct SteadyClock {
+    using duration = std::chrono::steady_clock::duration;
+    using time_point = std::chrono::steady_clock::time_point;
+
+    static time_point now() { return std::chrono::steady_clock::now(); }
+    static void sleepFor(duration d) { std::this_thread::sleep_for(d); }
+    static void sleepUntil(time_point t) { std::this_thread::sleep_until(t); }
+};
+
+class VirtualClock {
+public:
+    // also a std::chrono clock, so durations and time_points mix with the usual chrono arithmetic
+    using rep = std::int64_t;
+    using period = std::nano;
+    using duration = std::chrono::duration<rep, period>;
+    using time_point = std::chrono::time_point<VirtualClock>;
+    static constexpr bool is_steady = true;
+
+private:
+    struct Event {
+        time_point when;
+        std::uint64_t order;    // keeps events at the same instant in scheduling order
+        std::function<void()> fn;
+        bool operator>(const Event &other) const {
+            return when != other.when ? when > other.when : order > other.order;
+        }
+    };
+
+    static inline time_point now_{};
+    static inline std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    static inline std::uint64_t next_order_ = 0;
+    static inline std::uint64_t sleeps_ = 0;
+    static inline std::uint64_t late_deadlines_ = 0;
+    static inline duration worst_lateness_{0};
+
+    static void advanceTo(time_point t) {
+        while(!events_.empty() && events_.top().when <= t) {
+            Event ev = events_.top();
+            events_.pop();
+            now_ = ev.when;
+            ev.fn();
+        }
+        if(t > now_) {
+            now_ = t;
+        }
+    }
+
+public:
+    static time_point now() { return now_; }
+
+    static void sleepFor(duration d) {
+        sleeps_++;
+        advanceTo(now_ + (d > duration::zero() ? d : duration::zero()));
+    }
+
+    static void sleepUntil(time_point t) {
+        sleeps_++;
+        if(t < now_) {
+            late_deadlines_++;
+            if(now_ - t > worst_lateness_) {
+                worst_lateness_ = now_ - t;
+            }
+        }
+        advanceTo(t);
+    }
+
+    template <typename Rep, typename Period>
+    static void sleepFor(std::chrono::duration<Rep, Period> d) {
+        sleepFor(std::chrono::duration_cast<duration>(d));
+    }
+
+    // Runs fn once simulated time reaches `when` (immediately on the next sleep if it's already past)
+    static void at(time_point when, std::function<void()> fn) {
+        events_.push({when, next_order_++, std::move(fn)});
+    }
+
+    template <typename Rep, typename Period>
+    static void after(std::chrono::duration<Rep, Period> d, std::function<void()> fn) {
+        at(now_ + std::chrono::duration_cast<duration>(d), std::move(fn));
+    }
+
+    // Runs every pending event without the code under test sleeping
+    static void drain() {
+        while(!events_.empty()) {
+            advanceTo(events_.top().when);
+        }
+    }
+
+    static void reset() {
+        now_ = time_point{};
+        events_ = decltype(events_)();
+        next_order_ = 0;
+        sleeps_ = 0;
+        late_deadlines_ = 0;
+        worst_lateness_ = duration::zero();
+    }
+
+    static std::uint64_t sleeps() { return sleeps_; }
+    static std::uint64_t lateDeadlines() { return late_deadlines_; }
+    static duration worstLateness() { return worst_lateness_; }
+};
@@ -0,0 +1,153 @@
+/*
+    Frequency, period and duty cycle of pulse trains (tachometers, flow sensors) from GPIO edge events.
+
+    Polling get_value() like two_button_GPIO.cpp misses edges above a few hundred Hz. The kernel instead timestamps
+    every edge in its interrupt handler and queues it, so the meter only has to read the queue in big batches
+    (request the lines with a large event_buffer_size and read 256 events per read()) and do the math on the
+    kernel timestamps, which don't depend on when the program got around to reading them.
+
+    Per line the meter keeps the edges of the last window_ns in a ring, each edge stored with running totals of
+    rising edges and high time, so the stats for the whole window are two subtractions no matter how many edges it
+    holds. Old edges are dropped from the tail as new ones arrive. Sequence number gaps (line_seqno, per line)
+    mean the kernel queue overflowed and events were lost, they are counted and the high time across a gap is
+    not trusted.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <linux/gpio.h>
+
+struct PulseStats {
+    bool valid;                 // at least two rising edges in the window
+    double frequency_hz;
+    double period_us;
+    double duty;                // 0..1, only meaningful with both edges requested
+    std::uint64_t edges;        // total edges seen on the line
+    std::uint64_t dropped;      // events lost to queue overflow (from sequence gaps)
+};
+
+class FrequencyMeter {
+private:
+    struct Edge {
+        std::uint64_t t;
+        std::uint64_t rises;        // rising edges up to and including this one
+        std::uint64_t high_ns;      // high time up to this edge
+        bool rising;
+    };
+
+    struct LineState {
+        std::uint32_t offset;
+        std::vector<Edge> ring;
+        std::uint64_t head = 0;     // next write position (monotonic, masked on access)
+        std::uint64_t tail = 0;
+        std::uint32_t last_seqno = 0;
+        std::uint64_t edges = 0;
+        std::uint64_t dropped = 0;
+        std::uint64_t rises = 0;
+        std::uint64_t high_ns = 0;
+    };
+
+    std::vector<LineState> lines_;
+    std::uint64_t window_ns_;
+    std::uint64_t mask_;
+
+    LineState *find(std::uint32_t offset) {
+        for(auto &l : lines_) {
+            if(l.offset == offset) {
+                return &l;
+            }
+        }
+        return nullptr;
+    }
+
+    void evict(LineState &l, std::uint64_t now_ns) {
+        while(l.tail != l.head && now_ns - l.ring[l.tail & mask_].t > window_ns_) {
+            l.tail++;
+        }
+    }
+
+public:
+    // capacity: edges kept per line, rounded up to a power of two; should cover window * 2 * max frequency
+    FrequencyMeter(const std::vector<std::uint32_t> &offsets, std::uint64_t window_ns, std::uint32_t capacity = 16384)
+        : window_ns_(window_ns)
+    {
+        std::uint32_t cap = 1;
+        while(cap < capacity) {
+            cap <<= 1;
+        }
+        mask_ = cap - 1;
+        for(std::uint32_t offset : offsets) {
+            LineState l;
+            l.offset = offset;
+            l.ring.resize(cap);
+            lines_.push_back(std::move(l));
+        }
+    }
+
+    void process(const struct gpio_v2_line_event *events, std::size_t count) {
+        for(std::size_t i = 0; i < count; i++) {
+            const auto &ev = events[i];
+            LineState *l = find(ev.offset);
+            if(l == nullptr) {
+                continue;
+            }
+            bool gap = l->edges > 0 && ev.line_seqno != l->last_seqno + 1;
+            if(gap) {
+                l->dropped += ev.line_seqno - l->last_seqno - 1;
+            }
+            l->last_seqno = ev.line_seqno;
+            l->edges++;
+
+            bool rising = ev.id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+            if(rising) {
+                l->rises++;
+            } else if(!gap && l->head != l->tail) {
+                const Edge &prev = l->ring[(l->head - 1) & mask_];
+                if(prev.rising) {
+                    l->high_ns += ev.timestamp_ns - prev.t;
+                }
+            }
+
+            if(l->head - l->tail == l->ring.size()) {
+                l->tail++;      // ring full, the window is effectively shorter until the rate drops
+            }
+            l->ring[l->head & mask_] = {ev.timestamp_ns, l->rises, l->high_ns, rising};
+            l->head++;
+        }
+    }
+
+    PulseStats stats(std::size_t index, std::uint64_t now_ns) {
+        LineState &l = lines_[index];
+        PulseStats s = {false, 0, 0, 0, l.edges, l.dropped};
+        evict(l, now_ns);
+
+        // first and last rising edge inside the window, at most a couple of steps from each end
+        std::uint64_t first = l.tail, last = l.head;
+        while(first != l.head && !l.ring[first & mask_].rising) {
+            first++;
+        }
+        while(last != first && !l.ring[(last - 1) & mask_].rising) {
+            last--;
+        }
+        if(first == l.head || last - 1 == first) {
+            return s;
+        }
+        const Edge &a = l.ring[first & mask_];
+        const Edge &b = l.ring[(last - 1) & mask_];
+        double span_ns = static_cast<double>(b.t - a.t);
+        double periods = static_cast<double>(b.rises - a.rises);
+        if(span_ns <= 0 || periods <= 0) {
+            return s;
+        }
+        s.valid = true;
+        s.period_us = span_ns / periods / 1000.0;
+        s.frequency_hz = periods * 1e9 / span_ns;
+        s.duty = static_cast<double>(b.high_ns - a.high_ns) / span_ns;
+        return s;
+    }
+
+    std::size_t size() const { return lines_.size(); }
+    std::uint32_t offset(std::size_t index) const { return lines_[index].offset; }
+};
@@ -0,0 +1,197 @@
+/*
+    Thin wrapper around a GPIO v2 character device line request (the same ioctls as LED_blink_GPIO_v2_API.cpp),
+    so the demos don't have to repeat the open/memset/ioctl boilerplate.
+
+    All lines of one request share the same flags. Values and masks are in request order: bit i is offsets[i].
+    Errors are reported with std::system_error like LED_blink_GPIO_deprecated_v1_API.cpp.
+
+    A TraceRecorder can be attached to log every write, read and edge event. A GpioLines built from a TraceReplayer
+    doesn't touch any hardware and serves the recorded reads and edges through the same calls instead.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "trace.hpp"
+#include "probes.hpp"
+
+class GpioLines {
+private:
+    int chip_fd_ = -1;
+    int line_fd_ = -1;
+    std::vector<std::uint32_t> offsets_;
+    TraceRecorder *recorder_ = nullptr;
+    TraceReplayer *replayer_ = nullptr;
+    std::uint32_t trace_source_ = 0;
+
+    // Prevent copying
+    GpioLines(const GpioLines&) = delete;
+    GpioLines& operator=(const GpioLines&) = delete;
+
+public:
+    GpioLines(const char *chip_path, const std::vector<std::uint32_t> &offsets, std::uint64_t flags,
+              const char *consumer, std::uint32_t event_buffer_size = 0)
+        : offsets_(offsets)
+    {
+        if(offsets.empty() || offsets.size() > GPIO_V2_LINES_MAX) {
+            throw std::system_error(EINVAL, std::system_category(), "Invalid number of GPIO lines");
+        }
+
+        chip_fd_ = open(chip_path, O_RDWR | O_CLOEXEC);
+        if(chip_fd_ < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to open GPIO chip");
+        }
+
+        struct gpio_v2_line_request req;
+        memset(&req, 0, sizeof(req));
+        req.config.flags = flags;
+        req.num_lines = offsets.size();
+        req.event_buffer_size = event_buffer_size;
+        for(size_t i = 0; i < offsets.size(); i++) {
+            req.offsets[i] = offsets[i];
+        }
+        strncpy(req.consumer, consumer, sizeof(req.consumer) - 1);
+
+        if(ioctl(chip_fd_, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+            int err = errno;
+            close(chip_fd_);
+            throw std::system_error(err, std::system_category(), "Failed to get GPIO lines");
+        }
+        line_fd_ = req.fd;
+        trace_source_ = offsets[0];
+    }
+
+    // Replay-only lines: nothing is opened, reads and edges come from the trace recorded under `source`.
+    GpioLines(TraceReplayer &replayer, const std::vector<std::uint32_t> &offsets, std::uint32_t source)
+        : offsets_(offsets), replayer_(&replayer), trace_source_(source)
+    {
+    }
+
+    ~GpioLines() {
+        if(line_fd_ >= 0) {
+            close(line_fd_);
+        }
+        if(chip_fd_ >= 0) {
+            close(chip_fd_);
+        }
+    }
+
+    // Records under offsets[0] unless another source id is given
+    void attachRecorder(TraceRecorder *recorder) { recorder_ = recorder; }
+    void attachRecorder(TraceRecorder *recorder, std::uint32_t source) {
+        recorder_ = recorder;
+        trace_source_ = source;
+    }
+
+    void setValues(std::uint64_t mask, std::uint64_t bits) {
+        if(recorder_) {
+            recorder_->lineWrite(trace_source_, mask, bits);
+        }
+        if(replayer_) {
+            // nothing to drive, but the recorded write keeps the replay clock where it was in the recording
+            replayer_->next(TraceType::LineWrite, trace_source_);
+            return;
+        }
+
+        struct gpio_v2_line_values values;
+        values.mask = mask;
+        values.bits = bits;
+        EMB_PROBE3(gpio_set_start, line_fd_, mask, bits);
+        if(ioctl(line_fd_, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to set GPIO values");
+        }
+        EMB_PROBE1(gpio_set_end, line_fd_);
+    }
+
+    void setValue(std::size_t index, int value) {
+        setValues(1ULL << index, value ? 1ULL << index : 0);
+    }
+
+    std::uint64_t getValues(std::uint64_t mask) {
+        if(replayer_) {
+            const TraceRecord *rec = replayer_->next(TraceType::LineValues, trace_source_);
+            return rec ? rec->b & mask : 0;
+        }
+
+        struct gpio_v2_line_values values;
+        values.mask = mask;
+        values.bits = 0;
+        EMB_PROBE2(gpio_get_start, line_fd_, mask);
+        if(ioctl(line_fd_, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to get GPIO values");
+        }
+        EMB_PROBE2(gpio_get_end, line_fd_, values.bits);
+        if(recorder_) {
+            recorder_->lineValues(trace_source_, mask, values.bits);
+        }
+        return values.bits & mask;
+    }
+
+    int getValue(std::size_t index) {
+        return getValues(1ULL << index) ? 1 : 0;
+    }
+
+    // Waits for edge events, returns false on timeout. timeout_ms < 0 waits forever.
+    // In replay mode the timeout is measured against the recorded edge times (TraceReplayer::waitEdge), and it
+    // also returns false once the trace has no more edges for this source.
+    bool waitEvent(int timeout_ms) {
+        if(replayer_) {
+            return replayer_->waitEdge(trace_source_, timeout_ms);
+        }
+
+        struct pollfd pfd = {line_fd_, POLLIN, 0};
+        int ret;
+        while((ret = poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR) {
+        }
+        if(ret < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to poll GPIO events");
+        }
+        return ret > 0;
+    }
+
+    // Reads up to max_events queued edge events in one read(), blocks if none are queued.
+    std::size_t readEvents(struct gpio_v2_line_event *events, std::size_t max_events) {
+        if(replayer_) {
+            const TraceRecord *rec = max_events ? replayer_->nextEdge(trace_source_) : nullptr;
+            if(!rec) {
+                return 0;
+            }
+            memset(&events[0], 0, sizeof(events[0]));
+            events[0].timestamp_ns = rec->time_ns;
+            events[0].id = rec->type == TraceType::EdgeRising ? GPIO_V2_LINE_EVENT_RISING_EDGE
+                                                              : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+            events[0].offset = static_cast<std::uint32_t>(rec->a);
+            events[0].line_seqno = static_cast<std::uint32_t>(rec->b);
+            return 1;
+        }
+
+        ssize_t n;
+        while((n = read(line_fd_, events, max_events * sizeof(events[0]))) < 0 && errno == EINTR) {
+        }
+        if(n < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to read GPIO events");
+        }
+        std::size_t count = static_cast<std::size_t>(n) / sizeof(events[0]);
+        EMB_PROBE3(gpio_events, line_fd_, count, count ? events[0].timestamp_ns : 0);
+        if(recorder_) {
+            for(std::size_t i = 0; i < count; i++) {
+                recorder_->edge(trace_source_, events[i].timestamp_ns, events[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE,
+                                events[i].offset, events[i].line_seqno);
+            }
+        }
+        return count;
+    }
+
+    const std::vector<std::uint32_t> &offsets() const { return offsets_; }
+    std::size_t size() const { return offsets_.size(); }
+    int fd() const { return line_fd_; }
+};
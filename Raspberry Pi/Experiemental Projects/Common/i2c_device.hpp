@@ -0,0 +1,133 @@
+/*
+    I2C wrapper on /dev/i2c-N. Register reads are done as one I2C_RDWR transaction (write register address,
+    repeated start, read data), which is the ADDR+WR / ADDR+R sequence described in ADS1115_I2C_setup.txt
+    without releasing the bus in between.
+
+    Same trace hooks as GpioLines and SpiDevice: received bytes are recorded as BusTransfer, writes as BusWrite.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "trace.hpp"
+#include "probes.hpp"
+
+class I2cDevice {
+private:
+    int fd_ = -1;
+    std::uint16_t address_;
+    TraceRecorder *recorder_ = nullptr;
+    TraceReplayer *replayer_ = nullptr;
+    std::uint32_t trace_source_ = 0;
+
+    // Prevent copying
+    I2cDevice(const I2cDevice&) = delete;
+    I2cDevice& operator=(const I2cDevice&) = delete;
+
+public:
+    I2cDevice(const char *path, std::uint16_t address)
+        : address_(address), trace_source_(address)
+    {
+        fd_ = open(path, O_RDWR | O_CLOEXEC);
+        if(fd_ < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to open I2C bus");
+        }
+        if(ioctl(fd_, I2C_SLAVE, address) < 0) {
+            int err = errno;
+            close(fd_);
+            throw std::system_error(err, std::system_category(), "Failed to select I2C address");
+        }
+    }
+
+    // Replay-only device, reads return what was recorded under `source`
+    I2cDevice(TraceReplayer &replayer, std::uint16_t address, std::uint32_t source)
+        : address_(address), replayer_(&replayer), trace_source_(source)
+    {
+    }
+
+    ~I2cDevice() {
+        if(fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    void attachRecorder(TraceRecorder *recorder) { recorder_ = recorder; }
+    void attachRecorder(TraceRecorder *recorder, std::uint32_t source) {
+        recorder_ = recorder;
+        trace_source_ = source;
+    }
+
+    // Runs all messages in a single I2C_RDWR ioctl with repeated starts between them
+    void transfer(struct i2c_msg *msgs, std::size_t count) {
+        if(replayer_) {
+            for(std::size_t i = 0; i < count; i++) {
+                if((msgs[i].flags & I2C_M_RD) == 0) {
+                    continue;
+                }
+                const TraceRecord *rec = replayer_->next(TraceType::BusTransfer, trace_source_);
+                memset(msgs[i].buf, 0, msgs[i].len);
+                if(rec) {
+                    memcpy(msgs[i].buf, replayer_->payload(*rec), rec->a < msgs[i].len ? rec->a : msgs[i].len);
+                }
+            }
+            return;
+        }
+
+        struct i2c_rdwr_ioctl_data data;
+        data.msgs = msgs;
+        data.nmsgs = static_cast<std::uint32_t>(count);
+        EMB_PROBE3(i2c_transfer_start, fd_, count, address_);
+        int ret = ioctl(fd_, I2C_RDWR, &data);
+        EMB_PROBE2(i2c_transfer_end, fd_, ret);
+        if(ret < 0) {
+            throw std::system_error(errno, std::system_category(), "I2C transfer failed");
+        }
+
+        if(recorder_) {
+            for(std::size_t i = 0; i < count; i++) {
+                recorder_->bus(trace_source_, (msgs[i].flags & I2C_M_RD) != 0, msgs[i].buf, msgs[i].len);
+            }
+        }
+    }
+
+    void write(const std::uint8_t *data, std::size_t len) {
+        struct i2c_msg msg = {address_, 0, static_cast<std::uint16_t>(len), const_cast<std::uint8_t *>(data)};
+        transfer(&msg, 1);
+    }
+
+    void readRegisters(std::uint8_t reg, std::uint8_t *data, std::size_t len) {
+        struct i2c_msg msgs[2] = {
+            {address_, 0, 1, &reg},
+            {address_, I2C_M_RD, static_cast<std::uint16_t>(len), data},
+        };
+        transfer(msgs, 2);
+    }
+
+    void writeRegister(std::uint8_t reg, std::uint8_t value) {
+        std::uint8_t buf[2] = {reg, value};
+        write(buf, 2);
+    }
+
+    // 16-bit big-endian register, e.g. the ADS1115 conversion and config registers
+    std::uint16_t readRegister16(std::uint8_t reg) {
+        std::uint8_t buf[2];
+        readRegisters(reg, buf, 2);
+        return static_cast<std::uint16_t>((buf[0] << 8) | buf[1]);
+    }
+
+    void writeRegister16(std::uint8_t reg, std::uint16_t value) {
+        std::uint8_t buf[3] = {reg, static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value)};
+        write(buf, 3);
+    }
+
+    std::uint16_t address() const { return address_; }
+    int fd() const { return fd_; }
+};
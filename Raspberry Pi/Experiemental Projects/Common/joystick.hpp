@@ -0,0 +1,157 @@
+/*
+    Analog joystick (KY-023 style: X, Y pots and a push button) turned into a stream of change events.
+
+    Raw 10-bit readings wobble by a few counts even with the stick at rest, so acting on every reading (like the
+    voltage > 2 check in SPI_0_ADC_joystick.cpp) means doing work on every loop iteration. Here each axis goes
+    through:
+
+        centre      measured at rest by calibrate(), the two pots rarely sit exactly at 512
+        deadzone    counts around the centre that read as 0
+        quantise    the rest of each half mapped to 1..levels (and -1..-levels), each half scaled on its own
+        hysteresis  a level only changes once the reading is that many counts past the boundary
+
+    and the button is a threshold on its channel (SW to GND with a pull-up, so pressed reads low) that must agree on
+    two scans in a row. update() returns true only when the quantised state differs from the last emitted one.
+
+    Delay: the time from the first scan that showed the new state (ignoring hysteresis and debounce) to the event is
+    kept as worst and total, the caller adds at most one scan period on top for the change happening between scans.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+struct JoystickConfig {
+    std::uint16_t centre_x = 512;
+    std::uint16_t centre_y = 512;
+    std::uint16_t deadzone = 40;            // counts
+    std::uint8_t levels = 4;                // steps per direction
+    std::uint16_t hysteresis = 12;          // counts
+    std::uint16_t button_threshold = 200;   // below is pressed
+};
+
+struct JoystickSample {
+    std::uint16_t x;
+    std::uint16_t y;
+    std::uint16_t button;
+    std::uint64_t time_ns;
+};
+
+struct JoystickState {
+    std::int8_t x;
+    std::int8_t y;
+    bool pressed;
+
+    bool operator==(const JoystickState &other) const {
+        return x == other.x && y == other.y && pressed == other.pressed;
+    }
+    bool operator!=(const JoystickState &other) const { return !(*this == other); }
+};
+
+struct JoystickEvent {
+    JoystickState state;
+    JoystickState previous;
+    std::uint64_t time_ns;      // scan that produced the event
+    std::uint64_t delay_ns;     // since the first scan showing the change
+};
+
+class Joystick {
+private:
+    static constexpr int fullScale = 1023;
+
+    JoystickConfig config_;
+    JoystickState state_ = {0, 0, false};
+    bool button_candidate_ = false;
+    std::uint64_t pending_since_ = 0;   // 0 = raw state agrees with state_
+    std::uint64_t samples_ = 0;
+    std::uint64_t events_ = 0;
+    std::uint64_t max_delay_ns_ = 0;
+    std::uint64_t total_delay_ns_ = 0;
+
+    // Level for a reading without hysteresis, shift moves the reading by that many counts first
+    int level(std::uint16_t raw, std::uint16_t centre, int shift = 0) const {
+        int offset = static_cast<int>(raw) - centre + shift;
+        int range = (offset < 0 ? centre : fullScale - centre) - config_.deadzone;
+        int magnitude = std::abs(offset) - config_.deadzone;
+        if(magnitude <= 0 || range <= 0) {
+            return 0;
+        }
+        int l = std::min<int>(config_.levels, magnitude * config_.levels / range + 1);
+        return offset < 0 ? -l : l;
+    }
+
+    int axis(std::uint16_t raw, std::uint16_t centre, int current) const {
+        int next = level(raw, centre);
+        if(next == current) {
+            return current;
+        }
+        // the reading has to get hysteresis counts further towards the new level before we believe it
+        int confirmed = level(raw, centre, next > current ? -config_.hysteresis : config_.hysteresis);
+        if((next > current && confirmed > current) || (next < current && confirmed < current)) {
+            return confirmed;
+        }
+        return current;
+    }
+
+    JoystickState raw(const JoystickSample &s) const {
+        return {static_cast<std::int8_t>(level(s.x, config_.centre_x)),
+                static_cast<std::int8_t>(level(s.y, config_.centre_y)),
+                s.button < config_.button_threshold};
+    }
+
+public:
+    explicit Joystick(const JoystickConfig &config = JoystickConfig()) : config_(config) {}
+
+    // Averages samples taken with the stick released, call with count > 0 before the first update()
+    void calibrate(const JoystickSample *samples, std::size_t count) {
+        std::uint64_t sx = 0, sy = 0;
+        for(std::size_t i = 0; i < count; i++) {
+            sx += samples[i].x;
+            sy += samples[i].y;
+        }
+        config_.centre_x = static_cast<std::uint16_t>((sx + count / 2) / count);
+        config_.centre_y = static_cast<std::uint16_t>((sy + count / 2) / count);
+    }
+
+    bool update(const JoystickSample &s, JoystickEvent &event) {
+        samples_++;
+
+        JoystickState next;
+        next.x = static_cast<std::int8_t>(axis(s.x, config_.centre_x, state_.x));
+        next.y = static_cast<std::int8_t>(axis(s.y, config_.centre_y, state_.y));
+        bool pressed = s.button < config_.button_threshold;
+        next.pressed = pressed == button_candidate_ ? pressed : state_.pressed;
+        button_candidate_ = pressed;
+
+        if(raw(s) != state_) {
+            if(pending_since_ == 0) {
+                pending_since_ = s.time_ns;
+            }
+        } else if(next == state_) {
+            pending_since_ = 0;
+        }
+
+        if(next == state_) {
+            return false;
+        }
+        event.previous = state_;
+        event.state = next;
+        event.time_ns = s.time_ns;
+        event.delay_ns = pending_since_ != 0 ? s.time_ns - pending_since_ : 0;
+        max_delay_ns_ = std::max(max_delay_ns_, event.delay_ns);
+        total_delay_ns_ += event.delay_ns;
+        events_++;
+        state_ = next;
+        pending_since_ = raw(s) != state_ ? s.time_ns : 0;
+        return true;
+    }
+
+    const JoystickState &state() const { return state_; }
+    const JoystickConfig &config() const { return config_; }
+    std::uint64_t samples() const { return samples_; }
+    std::uint64_t events() const { return events_; }
+    std::uint64_t maxDelayNs() const { return max_delay_ns_; }
+    std::uint64_t meanDelayNs() const { return events_ ? total_delay_ns_ / events_ : 0; }
+};
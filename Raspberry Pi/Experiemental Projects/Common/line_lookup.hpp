@@ -0,0 +1,282 @@
+/*
+    Resolve GPIO lines by name ("GPIO17", "ID_SDA", ...) instead of hard-coding /dev/gpiochip0 and an offset.
+
+    LineIndex::scan() walks every /dev/gpiochip*, asks each line for its name with GPIO_V2_GET_LINEINFO_IOCTL and keeps
+    a sorted name -> (chip, offset) table. On a Pi 5 the 40-pin header lines live on a different chip than on a Pi 4,
+    the index finds them either way.
+
+    Scanning costs one ioctl per line (a few hundred on a Pi 5), so LineIndex::open() keeps the table in a small text
+    cache file keyed on /proc/sys/kernel/random/boot_id. The next process on the same boot reads the file instead of
+    rescanning, a reboot (or a name missing from the cache, e.g. after loading an overlay) triggers a fresh scan.
+
+    The cache decides which chip and offset a root-run demo drives, so it lives in a directory only its owner can
+    write: /run/gpio-line-index for root, $XDG_RUNTIME_DIR or a 0700 /tmp/gpio-line-index-<uid> otherwise. A
+    directory or file that isn't owned by the current user or is writable by others is ignored (scan every time),
+    and the file is written through mkstemp, never through a name someone else could have planted.
+
+    Cache file:
+        gpio-line-index 1 <boot id>
+        <chip path>\t<offset>\t<name>
+        ...
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <system_error>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+struct LineLocation {
+    std::string name;
+    std::string chip;
+    std::uint32_t offset;
+};
+
+inline std::string kernelBootId() {
+    std::ifstream file("/proc/sys/kernel/random/boot_id");
+    std::string id;
+    std::getline(file, id);
+    return id;
+}
+
+inline std::string defaultLineCachePath() {
+    if(geteuid() == 0) {
+        return "/run/gpio-line-index/cache";
+    }
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    if(runtime && *runtime) {
+        return std::string(runtime) + "/gpio-line-index";
+    }
+    return "/tmp/gpio-line-index-" + std::to_string(geteuid()) + "/cache";
+}
+
+// Only the current user may write there: owned by us, no group/other write bit
+inline bool ownedPrivately(const struct stat &st) {
+    return st.st_uid == geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Creates the directory holding path (0700) if missing, false if it isn't a private directory of ours
+inline bool privateCacheDir(const std::string &path) {
+    std::string::size_type slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    if(mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    struct stat st;
+    return lstat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && ownedPrivately(st);
+}
+
+class LineIndex {
+private:
+    std::vector<LineLocation> lines_;   // sorted by name
+    bool from_cache_ = false;
+
+    // Stable, so of two chips exporting the same name the one scanned (and cached) first stays in front
+    void sort() {
+        std::stable_sort(lines_.begin(), lines_.end(),
+                         [](const LineLocation &a, const LineLocation &b) { return a.name < b.name; });
+    }
+
+    static void scanChip(const std::string &path, std::vector<LineLocation> &out) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            return;     // no permission on this chip, skip it rather than failing the whole scan
+        }
+        struct gpiochip_info chip;
+        memset(&chip, 0, sizeof(chip));
+        if(ioctl(fd, GPIO_GET_CHIPINFO_IOCTL, &chip) < 0) {
+            close(fd);
+            return;
+        }
+        for(std::uint32_t offset = 0; offset < chip.lines; offset++) {
+            struct gpio_v2_line_info info;
+            memset(&info, 0, sizeof(info));
+            info.offset = offset;
+            if(ioctl(fd, GPIO_V2_GET_LINEINFO_IOCTL, &info) < 0 || info.name[0] == '\0') {
+                continue;
+            }
+            out.push_back({std::string(info.name, strnlen(info.name, sizeof(info.name))), path, offset});
+        }
+        close(fd);
+    }
+
+public:
+    static LineIndex scan(const char *dev_dir = "/dev") {
+        LineIndex index;
+        DIR *dir = opendir(dev_dir);
+        if(dir == nullptr) {
+            throw std::system_error(errno, std::system_category(), "Failed to list GPIO chips");
+        }
+        std::vector<std::string> chips;
+        while(struct dirent *entry = readdir(dir)) {
+            if(strncmp(entry->d_name, "gpiochip", 8) == 0) {
+                chips.push_back(std::string(dev_dir) + "/" + entry->d_name);
+            }
+        }
+        closedir(dir);
+        // numeric order so gpiochip0 wins over gpiochip10 when two chips export the same name
+        std::sort(chips.begin(), chips.end(), [](const std::string &a, const std::string &b) {
+            return a.size() != b.size() ? a.size() < b.size() : a < b;
+        });
+        for(const auto &chip : chips) {
+            scanChip(chip, index.lines_);
+        }
+        index.sort();
+        return index;
+    }
+
+    // Loads the cache if it exists, is private to this user and belongs to the running boot
+    bool load(const std::string &path, const std::string &boot_id) {
+        if(!privateCacheDir(path)) {
+            return false;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        if(fd < 0) {
+            return false;
+        }
+        struct stat st;
+        std::string text;
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && ownedPrivately(st)) {
+            char chunk[4096];
+            ssize_t n;
+            while((n = read(fd, chunk, sizeof(chunk))) > 0) {
+                text.append(chunk, static_cast<std::size_t>(n));
+            }
+        }
+        close(fd);
+
+        std::istringstream file(text);
+        std::string magic, id;
+        int version = 0;
+        if(!(file >> magic >> version >> id) || magic != "gpio-line-index" || version != 1 || id != boot_id) {
+            return false;
+        }
+        file.ignore(1);
+        lines_.clear();
+        std::string chip, offset, name;
+        while(std::getline(file, chip, '\t') && std::getline(file, offset, '\t') && std::getline(file, name)) {
+            lines_.push_back({name, chip, static_cast<std::uint32_t>(std::strtoul(offset.c_str(), nullptr, 10))});
+        }
+        sort();
+        from_cache_ = true;
+        return true;
+    }
+
+    // Written to a fresh mkstemp file and renamed, so a process starting at the same time never reads half a cache
+    // and nothing is written through a name another user could have created
+    void save(const std::string &path, const std::string &boot_id) const {
+        if(!privateCacheDir(path)) {
+            throw std::system_error(EPERM, std::system_category(), "Line cache directory is not private");
+        }
+        std::ostringstream text;
+        text << "gpio-line-index 1 " << boot_id << "\n";
+        for(const auto &line : lines_) {
+            text << line.chip << '\t' << line.offset << '\t' << line.name << '\n';
+        }
+        const std::string data = text.str();
+
+        std::vector<char> tmp(path.begin(), path.end());
+        const char suffix[] = ".XXXXXX";
+        tmp.insert(tmp.end(), suffix, suffix + sizeof(suffix));
+        int fd = mkstemp(tmp.data());
+        if(fd < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to write line cache");
+        }
+        std::size_t done = 0;
+        while(done < data.size()) {
+            ssize_t n = write(fd, data.data() + done, data.size() - done);
+            if(n < 0 && errno == EINTR) {
+                continue;
+            }
+            if(n <= 0) {
+                int err = errno;
+                close(fd);
+                unlink(tmp.data());
+                throw std::system_error(err, std::system_category(), "Failed to write line cache");
+            }
+            done += static_cast<std::size_t>(n);
+        }
+        close(fd);
+        if(rename(tmp.data(), path.c_str()) != 0) {
+            int err = errno;
+            unlink(tmp.data());
+            throw std::system_error(err, std::system_category(), "Failed to replace line cache");
+        }
+    }
+
+    // Cached index for this boot, scanning (and refreshing the cache) only when needed
+    static LineIndex open(const std::string &cache_path = defaultLineCachePath()) {
+        const std::string boot_id = kernelBootId();
+        LineIndex index;
+        if(index.load(cache_path, boot_id)) {
+            return index;
+        }
+        index = scan();
+        try {
+            index.save(cache_path, boot_id);
+        } catch(const std::exception &) {
+            // no private place for the cache only costs us the next startup
+        }
+        return index;
+    }
+
+    const LineLocation *find(const std::string &name) const {
+        auto it = std::lower_bound(lines_.begin(), lines_.end(), name,
+                                   [](const LineLocation &line, const std::string &n) { return line.name < n; });
+        return it != lines_.end() && it->name == name ? &*it : nullptr;
+    }
+
+    const std::vector<LineLocation> &lines() const { return lines_; }
+    bool fromCache() const { return from_cache_; }
+};
+
+// Resolves names that must all be on one chip (one line request can't span chips).
+// A name missing from a cached index triggers one rescan before giving up.
+inline std::string resolveLines(const std::vector<std::string> &names, std::vector<std::uint32_t> &offsets,
+                                const std::string &cache_path = defaultLineCachePath()) {
+    LineIndex index = LineIndex::open(cache_path);
+    std::string missing_name;
+    for(int attempt = 0; attempt < 2; attempt++) {
+        std::string chip;
+        offsets.clear();
+        missing_name.clear();
+        for(const auto &name : names) {
+            const LineLocation *line = index.find(name);
+            if(line == nullptr) {
+                missing_name = name;
+                break;
+            }
+            if(!chip.empty() && chip != line->chip) {
+                throw std::runtime_error("GPIO lines " + names[0] + " and " + name + " are on different chips");
+            }
+            chip = line->chip;
+            offsets.push_back(line->offset);
+        }
+        if(missing_name.empty()) {
+            return chip;
+        }
+        if(!index.fromCache()) {
+            break;
+        }
+        index = LineIndex::scan();
+        try {
+            index.save(cache_path, kernelBootId());
+        } catch(const std::exception &) {
+        }
+    }
+    throw std::runtime_error("GPIO line " + missing_name + " not found on any chip");
+}
@@ -0,0 +1,69 @@
+/*
+    MCP3008 8-channel 10-bit ADC on top of SpiDevice.
+
+    A conversion is three bytes: start bit, single-ended flag + channel, then the 10-bit result clocked out in the
+    second and third byte (same framing as readADC() in SPI_0_ADC_joystick.cpp). The chip starts a new conversion on
+    every falling edge of chip select, so reading several channels means several transfers with CS released in
+    between. readChannels() puts them all in one SPI_IOC_MESSAGE with cs_change set, which costs one syscall for the
+    whole scan instead of one per channel, and the channels are sampled a few microseconds apart.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <linux/spi/spidev.h>
+
+#include "spi_device.hpp"
+
+class Mcp3008 {
+private:
+    SpiDevice &spi_;
+
+    // Prevent copying
+    Mcp3008(const Mcp3008&) = delete;
+    Mcp3008& operator=(const Mcp3008&) = delete;
+
+public:
+    static constexpr std::size_t channels = 8;
+    static constexpr std::uint16_t maxValue = 1023;
+
+    explicit Mcp3008(SpiDevice &spi) : spi_(spi) {}
+
+    std::uint16_t readChannel(std::uint8_t channel) {
+        std::uint16_t value;
+        readChannels(&channel, &value, 1);
+        return value;
+    }
+
+    // Reads count channels (any order, repeats allowed) in a single ioctl, values[i] belongs to channel_list[i]
+    void readChannels(const std::uint8_t *channel_list, std::uint16_t *values, std::size_t count) {
+        if(count == 0 || count > channels) {
+            throw std::invalid_argument("MCP3008 scan must have 1 to 8 channels");
+        }
+        std::uint8_t tx[channels][3];
+        std::uint8_t rx[channels][3];
+        struct spi_ioc_transfer tr[channels];
+        memset(tr, 0, sizeof(tr));
+        for(std::size_t i = 0; i < count; i++) {
+            tx[i][0] = 0x01;                                                // start bit
+            tx[i][1] = static_cast<std::uint8_t>(0x80 | ((channel_list[i] & 0x07) << 4));  // single-ended, channel
+            tx[i][2] = 0x00;
+            tr[i].tx_buf = reinterpret_cast<unsigned long>(tx[i]);
+            tr[i].rx_buf = reinterpret_cast<unsigned long>(rx[i]);
+            tr[i].len = 3;
+            tr[i].speed_hz = spi_.speed();
+            tr[i].bits_per_word = 8;
+            tr[i].cs_change = i + 1 < count;    // release CS between conversions, not after the last one
+        }
+        spi_.transfer(tr, count);
+        for(std::size_t i = 0; i < count; i++) {
+            values[i] = static_cast<std::uint16_t>(((rx[i][1] & 0x03) << 8) | rx[i][2]);
+        }
+    }
+
+    static float toVolts(std::uint16_t value, float vref = 3.3f) {
+        return value * vref / maxValue;
+    }
+};
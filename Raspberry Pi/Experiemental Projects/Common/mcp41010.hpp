@@ -0,0 +1,57 @@
+/*
+    MCP41010 single 10 kOhm digital potentiometer on top of SpiDevice.
+
+    Every command is two bytes: the command byte (write data to pot 0 = 0x11, shutdown = 0x21) and the wiper
+    position 0-255. The chip has no read-back, the last written position is kept here.
+
+    maxCounts() / fadeTo() make it an Output for BrightnessController (Shared/brightness.hpp). There is no fading
+    hardware, fadeTo() moves the wiper at once.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "spi_device.hpp"
+
+class Mcp41010 {
+private:
+    static constexpr std::uint8_t cmdWritePot0 = 0x11;
+    static constexpr std::uint8_t cmdShutdownPot0 = 0x21;
+
+    SpiDevice &spi_;
+    std::uint8_t wiper_ = 0;
+
+    // Prevent copying
+    Mcp41010(const Mcp41010&) = delete;
+    Mcp41010& operator=(const Mcp41010&) = delete;
+
+public:
+    static constexpr std::uint8_t maxWiper = 255;
+
+    explicit Mcp41010(SpiDevice &spi) : spi_(spi) {}
+
+    void setWiper(std::uint8_t value) {
+        std::uint8_t tx[2] = {cmdWritePot0, value};
+        std::uint8_t rx[2];
+        spi_.transfer(tx, rx, sizeof(tx));
+        wiper_ = value;
+    }
+
+    // Opens terminal A and connects the wiper to B, the next setWiper() wakes the pot up again
+    void shutdown() {
+        std::uint8_t tx[2] = {cmdShutdownPot0, 0};
+        std::uint8_t rx[2];
+        spi_.transfer(tx, rx, sizeof(tx));
+    }
+
+    std::uint8_t wiper() const { return wiper_; }
+
+    // BrightnessController output
+    std::uint32_t maxCounts() const { return maxWiper; }
+
+    bool fadeTo(std::uint32_t counts, std::uint32_t) {
+        setWiper(static_cast<std::uint8_t>(counts > maxWiper ? maxWiper : counts));
+        return true;
+    }
+};
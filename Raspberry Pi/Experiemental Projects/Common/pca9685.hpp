@@ -0,0 +1,159 @@
+/*
+    PCA9685 16-channel 12-bit PWM controller on top of I2cDevice, so servo pulses and LED dimming are timed by the
+    chip's own oscillator instead of a Pi thread that can be preempted.
+
+    Channel settings are kept in a shadow copy of the 64 LEDn_ON_L .. LEDn_OFF_H registers. setPulseWidth(),
+    setDuty() and setLevel() only change the copy, flush() sends all 16 channels as one I2C write starting at
+    LED0_ON_L: MODE1 auto-increment moves the register pointer along, so the whole update is a single I2C_RDWR
+    transaction (65 bytes, ~1.6 ms at 400 kHz). The chip picks up new values at the end of the running PWM period,
+    a pulse is never cut short half-way.
+
+    Servo side: writeFrame(widths_us, count, frame_start) is the Output interface of ServoMotion in
+    SG90 Servo Motor/servo_planner.hpp, one transaction per 20 ms frame for any number of servos.
+    LED side: setLevel(channel, 0-255) uses the same 0-255 scale as the MCP41010 wiper. Pca9685Channel wraps one
+    channel as a BrightnessController output (Shared/brightness.hpp), the gamma table then gets the full 4096 counts
+    instead of the wiper's 256.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+#include "i2c_device.hpp"
+
+class Pca9685 {
+public:
+    static constexpr std::size_t channels = 16;
+    static constexpr std::uint16_t fullScale = 4096;      // counts per PWM period
+    static constexpr std::uint16_t defaultAddress = 0x40;
+
+private:
+    static constexpr std::uint8_t regMode1 = 0x00;
+    static constexpr std::uint8_t regMode2 = 0x01;
+    static constexpr std::uint8_t regLed0OnL = 0x06;
+    static constexpr std::uint8_t regPrescale = 0xFE;
+
+    static constexpr std::uint8_t mode1Restart = 0x80;
+    static constexpr std::uint8_t mode1AutoIncrement = 0x20;
+    static constexpr std::uint8_t mode1Sleep = 0x10;
+    static constexpr std::uint8_t mode1AllCall = 0x01;
+    static constexpr std::uint8_t mode2OutDrv = 0x04;     // totem pole outputs, what servo and LED boards expect
+    static constexpr std::uint8_t fullBit = 0x10;         // bit 4 of LEDn_ON_H / LEDn_OFF_H
+
+    I2cDevice &i2c_;
+    float frequency_;
+    std::array<std::uint8_t, 1 + 4 * channels> regs_{};   // register address, then ON_L ON_H OFF_L OFF_H per channel
+    std::uint64_t transactions_ = 0;
+
+    // Prevent copying
+    Pca9685(const Pca9685&) = delete;
+    Pca9685& operator=(const Pca9685&) = delete;
+
+    void setCounts(std::size_t channel, std::uint16_t on, std::uint16_t off) {
+        if(channel >= channels) {
+            throw std::out_of_range("PCA9685 channel must be 0 to 15");
+        }
+        std::uint8_t *r = &regs_[1 + 4 * channel];
+        r[0] = static_cast<std::uint8_t>(on);
+        r[1] = static_cast<std::uint8_t>(on >> 8);
+        r[2] = static_cast<std::uint8_t>(off);
+        r[3] = static_cast<std::uint8_t>(off >> 8);
+    }
+
+public:
+    // pwm_hz: 50 for servos, LEDs are happier at a few hundred Hz; the chip does 24 to 1526 Hz
+    explicit Pca9685(I2cDevice &i2c, float pwm_hz = 50, float oscillator_hz = 25000000)
+        : i2c_(i2c)
+    {
+        long prescale = std::lround(oscillator_hz / (fullScale * pwm_hz)) - 1;
+        prescale = std::min(255L, std::max(3L, prescale));
+        frequency_ = oscillator_hz / (fullScale * (prescale + 1));
+
+        // the prescaler can only be written while the oscillator sleeps
+        i2c_.writeRegister(regMode1, mode1Sleep | mode1AutoIncrement | mode1AllCall);
+        i2c_.writeRegister(regPrescale, static_cast<std::uint8_t>(prescale));
+        i2c_.writeRegister(regMode2, mode2OutDrv);
+        i2c_.writeRegister(regMode1, mode1AutoIncrement | mode1AllCall);
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        i2c_.writeRegister(regMode1, mode1Restart | mode1AutoIncrement | mode1AllCall);
+
+        regs_[0] = regLed0OnL;
+        for(std::size_t c = 0; c < channels; c++) {
+            setDuty(c, 0);
+        }
+        flush();
+    }
+
+    // counts out of 4096 high per period, 0 and >= 4096 use the full off / full on bits (no glitch pulse)
+    void setDuty(std::size_t channel, std::uint16_t counts) {
+        if(counts == 0) {
+            setCounts(channel, 0, fullBit << 8);
+        } else if(counts >= fullScale) {
+            setCounts(channel, fullBit << 8, 0);
+        } else {
+            setCounts(channel, 0, counts);
+        }
+    }
+
+    void setPulseWidth(std::size_t channel, float us) {
+        float counts = us * 1e-6f * frequency_ * fullScale;
+        setDuty(channel, static_cast<std::uint16_t>(std::lround(std::min<float>(fullScale, std::max(0.0f, counts)))));
+    }
+
+    // LED brightness 0-255, linear in duty like the MCP41010 wiper is linear in resistance
+    void setLevel(std::size_t channel, std::uint8_t level) {
+        setDuty(channel, static_cast<std::uint16_t>((level * fullScale + 127) / 255));
+    }
+
+    // Sends all 16 channels in one transaction
+    void flush() {
+        i2c_.write(regs_.data(), regs_.size());
+        transactions_++;
+    }
+
+    // ServoMotion output: the chip times the pulses, the frame start only matters to the caller's pacing
+    template <typename TimePoint>
+    void writeFrame(const std::uint16_t *widths_us, std::size_t count, TimePoint) {
+        count = std::min(count, channels);
+        for(std::size_t c = 0; c < count; c++) {
+            setPulseWidth(c, widths_us[c]);
+        }
+        flush();
+    }
+
+    // Actual PWM frequency after rounding the prescaler
+    float frequency() const { return frequency_; }
+    std::uint64_t transactions() const { return transactions_; }
+};
+
+// One channel as a BrightnessController output. No fade hardware, like the MCP41010: fadeTo() sets the duty and
+// sends it at once (all 16 channels, one transaction), the smoothing comes from the update rate.
+class Pca9685Channel {
+private:
+    Pca9685 &pca_;
+    std::size_t channel_;
+
+public:
+    Pca9685Channel(Pca9685 &pca, std::size_t channel) : pca_(pca), channel_(channel) {
+        if(channel >= Pca9685::channels) {
+            throw std::out_of_range("PCA9685 channel must be 0 to 15");
+        }
+    }
+
+    std::uint32_t maxCounts() const { return Pca9685::fullScale; }
+
+    bool fadeTo(std::uint32_t counts, std::uint32_t) {
+        pca_.setDuty(channel_, static_cast<std::uint16_t>(std::min<std::uint32_t>(counts, Pca9685::fullScale)));
+        pca_.flush();
+        return true;
+    }
+
+    std::size_t channel() const { return channel_; }
+};
@@ -0,0 +1,188 @@
+/*
+    Precise waits for the 10 us ultrasonic trigger and the 500-2500 us servo pulses.
+
+    std::this_thread::sleep_for() ends up in nanosleep(), which wakes up late by the thread's timer slack (50 us by
+    default) plus scheduling latency. The strategies here trade CPU time for accuracy:
+
+        Nanosleep   clock_nanosleep(TIMER_ABSTIME), no spinning, same accuracy as sleep_for but no drift
+        SlackTuned  like Nanosleep after prctl(PR_SET_TIMERSLACK, 1), removes the 50 us slack from every wake-up
+        Spin        busy-waits on the CPU cycle counter (TSC on x86, CNTVCT_EL0 on 64-bit ARM), exact but burns a core
+        Hybrid      slack-tuned sleep until spin_margin before the deadline, then spin for the rest (default)
+
+    spin_margin starts at 80 us and calibrate() replaces it with the worst wake-up overshoot it measures, so the
+    sleep part practically never overshoots the deadline on its own. Waits shorter than the margin only spin.
+
+    Deadlines are CLOCK_MONOTONIC nanoseconds, the same clock as std::chrono::steady_clock on Linux.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <time.h>
+#include <sys/prctl.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum class WaitStrategy {
+    Nanosleep,
+    SlackTuned,
+    Spin,
+    Hybrid
+};
+
+class CycleCounter {
+private:
+    static inline double ticks_per_ns_ = 0;
+
+    static std::uint64_t monotonicNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+public:
+    static const char *name() {
+#if defined(__x86_64__) || defined(__i386__)
+        return "TSC";
+#elif defined(__aarch64__)
+        return "CNTVCT_EL0";
+#else
+        return "CLOCK_MONOTONIC";
+#endif
+    }
+
+    static std::uint64_t read() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        std::uint64_t v;
+        asm volatile("isb; mrs %0, cntvct_el0" : "=r"(v) :: "memory");
+        return v;
+#else
+        // 32-bit ARM kernels don't always let user space read the counter, the vDSO clock is the safe fallback
+        return monotonicNs();
+#endif
+    }
+
+    static double ticksPerNs() {
+        if(ticks_per_ns_ == 0) {
+#if defined(__aarch64__)
+            std::uint64_t freq;
+            asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+            ticks_per_ns_ = freq / 1e9;
+#elif defined(__x86_64__) || defined(__i386__)
+            // invariant TSC assumed (every x86 CPU from the last decade), measured against CLOCK_MONOTONIC over 20 ms
+            std::uint64_t t0 = monotonicNs(), c0 = read();
+            while(monotonicNs() - t0 < 20000000ULL) {
+            }
+            std::uint64_t t1 = monotonicNs(), c1 = read();
+            ticks_per_ns_ = static_cast<double>(c1 - c0) / (t1 - t0);
+#else
+            ticks_per_ns_ = 1.0;
+#endif
+        }
+        return ticks_per_ns_;
+    }
+
+    static std::uint64_t nowNs() { return monotonicNs(); }
+};
+
+class PrecisionSleep {
+private:
+    static inline std::int64_t spin_margin_ns_ = 80000;
+    static inline bool slack_set_ = false;
+
+    static void setSlack() {
+        if(!slack_set_) {
+            prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+            slack_set_ = true;
+        }
+    }
+
+    static void nanosleepUntil(std::uint64_t deadline_ns) {
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(deadline_ns / 1000000000ULL);
+        ts.tv_nsec = static_cast<long>(deadline_ns % 1000000000ULL);
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+    }
+
+    static void spinUntil(std::uint64_t deadline_ns) {
+        std::uint64_t now = CycleCounter::nowNs();
+        if(now >= deadline_ns) {
+            return;
+        }
+        std::uint64_t target = CycleCounter::read()
+                               + static_cast<std::uint64_t>((deadline_ns - now) * CycleCounter::ticksPerNs());
+        while(CycleCounter::read() < target) {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+    }
+
+public:
+    static void waitUntil(std::uint64_t deadline_ns, WaitStrategy strategy = WaitStrategy::Hybrid) {
+        switch(strategy) {
+        case WaitStrategy::Nanosleep:
+            nanosleepUntil(deadline_ns);
+            break;
+        case WaitStrategy::SlackTuned:
+            setSlack();
+            nanosleepUntil(deadline_ns);
+            break;
+        case WaitStrategy::Spin:
+            spinUntil(deadline_ns);
+            break;
+        case WaitStrategy::Hybrid: {
+            setSlack();
+            std::int64_t remaining = static_cast<std::int64_t>(deadline_ns - CycleCounter::nowNs());
+            if(remaining > spin_margin_ns_) {
+                nanosleepUntil(deadline_ns - spin_margin_ns_);
+            }
+            spinUntil(deadline_ns);
+            break;
+        }
+        }
+    }
+
+    static void waitFor(std::chrono::nanoseconds d, WaitStrategy strategy = WaitStrategy::Hybrid) {
+        waitUntil(CycleCounter::nowNs() + d.count(), strategy);
+    }
+
+    // Measures how late slack-tuned sleeps wake up on this machine and uses the worst case (plus 10%) as the
+    // spin margin. Takes samples * 200 us, run it once at startup with the real-time profile already applied.
+    static std::int64_t calibrate(int samples = 200) {
+        setSlack();
+        CycleCounter::ticksPerNs();
+        std::int64_t worst = 0;
+        for(int i = 0; i < samples; i++) {
+            std::uint64_t deadline = CycleCounter::nowNs() + 200000;
+            nanosleepUntil(deadline);
+            worst = std::max(worst, static_cast<std::int64_t>(CycleCounter::nowNs() - deadline));
+        }
+        spin_margin_ns_ = std::min<std::int64_t>(worst + worst / 10, 2000000);
+        return spin_margin_ns_;
+    }
+
+    static void setSpinMargin(std::chrono::nanoseconds margin) { spin_margin_ns_ = margin.count(); }
+    static std::int64_t spinMarginNs() { return spin_margin_ns_; }
+};
+
+// Clock policy (see clock.hpp) with hybrid precise sleeps, for ServoSweep and the other timing templates
+struct PrecisionClock {
+    using duration = std::chrono::steady_clock::duration;
+    using time_point = std::chrono::steady_clock::time_point;
+
+    static time_point now() { return std::chrono::steady_clock::now(); }
+    static void sleepFor(duration d) { PrecisionSleep::waitFor(d); }
+    static void sleepUntil(time_point t) {
+        PrecisionSleep::waitUntil(std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count());
+    }
+};
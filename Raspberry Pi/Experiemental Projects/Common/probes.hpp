@@ -0,0 +1,39 @@
+/*
+    USDT (user statically defined tracing) probes for the GPIO, SPI and I2C wrappers and the periodic loops.
+
+    Each probe compiles to a single nop plus a note in the ELF file, the arguments are only read when a tracer has
+    attached, so leaving them in release builds costs nothing measurable. Attach with bpftrace or perf, e.g.
+
+        sudo bpftrace -p $(pidof servo_motion) Common/bpftrace/gpio_latency.bt
+        sudo perf probe -x ./servo_motion sdt_embedded:gpio_set_start
+
+    Probes are enabled when <sys/sdt.h> is installed (systemtap-sdt-dev on Raspberry Pi OS / Debian),
+    build with -DEMBEDDED_NO_USDT to compile them out entirely.
+
+    provider "embedded":
+        gpio_set_start(fd, mask, bits)          gpio_set_end(fd)
+        gpio_get_start(fd, mask)                gpio_get_end(fd, bits)
+        gpio_events(fd, count, first_ts_ns)     after a batch of edge events was dequeued
+        spi_transfer_start(fd, count, len)      spi_transfer_end(fd, result)
+        i2c_transfer_start(fd, count, addr)     i2c_transfer_end(fd, result)
+        deadline_hit(id, lateness_ns)           deadline_miss(id, lateness_ns)
+*/
+
+#pragma once
+
+#if !defined(EMBEDDED_NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define EMBEDDED_USDT 1
+#endif
+#endif
+
+#ifdef EMBEDDED_USDT
+#define EMB_PROBE1(name, a)         DTRACE_PROBE1(embedded, name, a)
+#define EMB_PROBE2(name, a, b)      DTRACE_PROBE2(embedded, name, a, b)
+#define EMB_PROBE3(name, a, b, c)   DTRACE_PROBE3(embedded, name, a, b, c)
+#else
+#define EMB_PROBE1(name, a)         do {} while(0)
+#define EMB_PROBE2(name, a, b)      do {} while(0)
+#define EMB_PROBE3(name, a, b, c)   do {} while(0)
+#endif
@@ -0,0 +1,124 @@
+/*
+    Opt-in real-time profile for the timing loops (servo PWM, ultrasonic trigger, LED blink).
+
+    applyRtProfile() does, in this order:
+        1. mlockall(MCL_CURRENT | MCL_FUTURE) and turns off heap trimming / mmap'd allocations, then touches a chunk
+           of heap so later allocations don't page fault
+        2. prefaults the calling thread's stack
+        3. pins the calling thread to one CPU (by default the last one listed in /sys/devices/system/cpu/isolated,
+           boot with isolcpus=3 on a Pi 4/5 to get a CPU the scheduler leaves alone)
+        4. switches the calling thread to SCHED_FIFO
+
+    Only the calling thread is changed (plus the process wide memory lock), so call it at the start of the thread
+    that runs the timing loop. Needs root or CAP_SYS_NICE + CAP_IPC_LOCK, failures throw std::system_error.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <system_error>
+#include <pthread.h>
+#include <sched.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+struct RtProfile {
+    bool lock_memory = true;
+    std::size_t heap_prefault = 8 * 1024 * 1024;
+    std::size_t stack_prefault = 256 * 1024;    // must stay below the thread's stack size (8 MB for main by default)
+    int cpu = -1;                               // -1: last isolated CPU, or no pinning if none are isolated
+    int priority = 80;                          // SCHED_FIFO 1..99, 0 keeps SCHED_OTHER
+};
+
+// Last CPU listed in /sys/devices/system/cpu/isolated ("3" or "2-3" or "1,3"), -1 if none
+inline int isolatedCpu() {
+    std::ifstream file("/sys/devices/system/cpu/isolated");
+    std::string list;
+    if(!std::getline(file, list) || list.empty()) {
+        return -1;
+    }
+    std::size_t pos = list.find_last_of(",-");
+    return std::atoi(list.c_str() + (pos == std::string::npos ? 0 : pos + 1));
+}
+
+inline void lockMemory(std::size_t heap_prefault) {
+    if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        throw std::system_error(errno, std::system_category(), "mlockall failed");
+    }
+    // keep freed memory in the process and never hand out fresh mmap'd pages, both would fault again later
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    if(heap_prefault > 0) {
+        auto *heap = static_cast<volatile char *>(malloc(heap_prefault));
+        if(heap == nullptr) {
+            throw std::system_error(ENOMEM, std::system_category(), "Heap prefault failed");
+        }
+        long page = sysconf(_SC_PAGESIZE);
+        for(std::size_t i = 0; i < heap_prefault; i += page) {
+            heap[i] = 0;
+        }
+        free(const_cast<char *>(heap));
+    }
+}
+
+// noinline so the array really lives below the caller's frame
+__attribute__((noinline)) inline void prefaultStack(std::size_t bytes) {
+    auto *stack = static_cast<volatile char *>(alloca(bytes));
+    long page = sysconf(_SC_PAGESIZE);
+    for(std::size_t i = 0; i < bytes; i += page) {
+        stack[i] = 0;
+    }
+}
+
+inline void pinThreadToCpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if(err != 0) {
+        throw std::system_error(err, std::system_category(), "Failed to set CPU affinity");
+    }
+}
+
+inline void setFifoPriority(int priority) {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if(err != 0) {
+        throw std::system_error(err, std::system_category(), "Failed to set SCHED_FIFO");
+    }
+}
+
+inline void applyRtProfile(const RtProfile &profile = RtProfile()) {
+    if(profile.lock_memory) {
+        lockMemory(profile.heap_prefault);
+    }
+    if(profile.stack_prefault > 0) {
+        prefaultStack(profile.stack_prefault);
+    }
+    int cpu = profile.cpu >= 0 ? profile.cpu : isolatedCpu();
+    if(cpu >= 0) {
+        pinThreadToCpu(cpu);
+    }
+    if(profile.priority > 0) {
+        setFifoPriority(profile.priority);
+    }
+}
+
+// Used by the demos: applies the default profile when started with --rt
+inline bool rtRequested(int argc, char **argv) {
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--rt") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
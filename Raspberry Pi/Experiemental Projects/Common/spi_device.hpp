@@ -0,0 +1,128 @@
+/*
+    spidev wrapper with the same setup as spi_init() in SPI_0_ADC_joystick.cpp and SPI_0_digital_POT_MCP41010.cpp
+    (mode, bits per word, max speed), throwing std::system_error instead of printing and returning false.
+
+    With a TraceRecorder attached every received buffer is logged, a SpiDevice built from a TraceReplayer
+    returns the recorded bytes from transfer() without opening the device.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+#include "trace.hpp"
+#include "probes.hpp"
+
+class SpiDevice {
+private:
+    int fd_ = -1;
+    std::uint8_t mode_;
+    std::uint8_t bits_;
+    std::uint32_t speed_;
+    TraceRecorder *recorder_ = nullptr;
+    TraceReplayer *replayer_ = nullptr;
+    std::uint32_t trace_source_ = 0;
+
+    // Prevent copying
+    SpiDevice(const SpiDevice&) = delete;
+    SpiDevice& operator=(const SpiDevice&) = delete;
+
+public:
+    SpiDevice(const char *path, std::uint8_t mode = SPI_MODE_0, std::uint8_t bits = 8, std::uint32_t speed = 1000000)
+        : mode_(mode), bits_(bits), speed_(speed)
+    {
+        fd_ = open(path, O_RDWR | O_CLOEXEC);
+        if(fd_ < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to open SPI device");
+        }
+        if(ioctl(fd_, SPI_IOC_WR_MODE, &mode_) < 0) {
+            int err = errno;
+            close(fd_);
+            throw std::system_error(err, std::system_category(), "Failed to set SPI mode");
+        }
+        if(ioctl(fd_, SPI_IOC_WR_BITS_PER_WORD, &bits_) < 0) {
+            int err = errno;
+            close(fd_);
+            throw std::system_error(err, std::system_category(), "Failed to set SPI bits per word");
+        }
+        if(ioctl(fd_, SPI_IOC_WR_MAX_SPEED_HZ, &speed_) < 0) {
+            int err = errno;
+            close(fd_);
+            throw std::system_error(err, std::system_category(), "Failed to set SPI max speed");
+        }
+    }
+
+    // Replay-only device, transfers return what was recorded under `source`
+    SpiDevice(TraceReplayer &replayer, std::uint32_t source, std::uint32_t speed = 1000000)
+        : mode_(SPI_MODE_0), bits_(8), speed_(speed), replayer_(&replayer), trace_source_(source)
+    {
+    }
+
+    ~SpiDevice() {
+        if(fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    void attachRecorder(TraceRecorder *recorder, std::uint32_t source) {
+        recorder_ = recorder;
+        trace_source_ = source;
+    }
+
+    // Full-duplex transfer of len bytes, rx may be nullptr for write-only transfers
+    void transfer(const std::uint8_t *tx, std::uint8_t *rx, std::size_t len) {
+        struct spi_ioc_transfer tr;
+        memset(&tr, 0, sizeof(tr));
+        tr.tx_buf = reinterpret_cast<unsigned long>(tx);
+        tr.rx_buf = reinterpret_cast<unsigned long>(rx);
+        tr.len = static_cast<std::uint32_t>(len);
+        tr.speed_hz = speed_;
+        tr.bits_per_word = bits_;
+        transfer(&tr, 1);
+    }
+
+    // Several transfers in one SPI_IOC_MESSAGE ioctl (chip select toggles between them unless cs_change says otherwise)
+    void transfer(struct spi_ioc_transfer *transfers, std::size_t count) {
+        if(replayer_) {
+            for(std::size_t i = 0; i < count; i++) {
+                if(transfers[i].rx_buf == 0) {
+                    continue;
+                }
+                const TraceRecord *rec = replayer_->next(TraceType::BusTransfer, trace_source_);
+                auto *rx = reinterpret_cast<std::uint8_t *>(transfers[i].rx_buf);
+                memset(rx, 0, transfers[i].len);
+                if(rec) {
+                    memcpy(rx, replayer_->payload(*rec), rec->a < transfers[i].len ? rec->a : transfers[i].len);
+                }
+            }
+            return;
+        }
+
+        EMB_PROBE3(spi_transfer_start, fd_, count, transfers[0].len);
+        int ret = ioctl(fd_, SPI_IOC_MESSAGE(count), transfers);
+        EMB_PROBE2(spi_transfer_end, fd_, ret);
+        if(ret < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to send SPI message");
+        }
+
+        if(recorder_) {
+            for(std::size_t i = 0; i < count; i++) {
+                if(transfers[i].rx_buf) {
+                    recorder_->bus(trace_source_, true, reinterpret_cast<const std::uint8_t *>(transfers[i].rx_buf), transfers[i].len);
+                } else {
+                    recorder_->bus(trace_source_, false, reinterpret_cast<const std::uint8_t *>(transfers[i].tx_buf), transfers[i].len);
+                }
+            }
+        }
+    }
+
+    std::uint32_t speed() const { return speed_; }
+    std::uint8_t bitsPerWord() const { return bits_; }
+    int fd() const { return fd_; }
+};
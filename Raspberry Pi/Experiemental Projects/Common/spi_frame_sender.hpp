@@ -0,0 +1,86 @@
+/*
+    Master side of the framed SPI stream (Shared/spi_frame.hpp): batches samples and commands into frames, packs
+    the frames into transactions of up to transaction_bytes and sends each with one transfer.
+
+    Transport is anything with transfer(const uint8_t *tx, uint8_t *rx, size_t len): SpiDevice for the ESP32
+    slave, or the in-memory loopback of spi_frame_loopback.cpp. Only the bytes that carry frames are clocked out
+    (the slave sees the shorter transaction length), rounded up to whole words for the slave's DMA.
+
+    addSamples() splits long runs into frames of at most samples_per_frame and starts a new transaction whenever
+    the current one is full; flush() sends what is pending, call it once per period so samples don't wait.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../../Shared/spi_frame.hpp"
+
+template <typename Transport>
+class SpiFrameSender {
+private:
+    Transport &transport_;
+    std::vector<std::uint8_t> buffer_;
+    std::size_t samples_per_frame_;
+    std::uint32_t seq_ = 0;
+    SpiFrameWriter writer_;
+    std::uint64_t transactions_ = 0;
+    std::uint64_t frames_ = 0;
+    std::uint64_t bytes_ = 0;
+
+    // Prevent copying
+    SpiFrameSender(const SpiFrameSender&) = delete;
+    SpiFrameSender& operator=(const SpiFrameSender&) = delete;
+
+public:
+    SpiFrameSender(Transport &transport, std::size_t transaction_bytes = 4096, std::size_t samples_per_frame = 256)
+        : transport_(transport), buffer_(transaction_bytes & ~std::size_t(3)),
+          samples_per_frame_(samples_per_frame), writer_(buffer_.data(), buffer_.size(), seq_)
+    {
+        if(buffer_.size() < spi_frame::frameSize(spi_frame::commandSize) || samples_per_frame_ == 0) {
+            throw std::invalid_argument("SPI frame transaction too small");
+        }
+    }
+
+    void addSamples(const std::uint16_t *samples, std::size_t count) {
+        while(count > 0) {
+            std::size_t n = std::min({count, samples_per_frame_, writer_.sampleRoom()});
+            if(n == 0) {
+                flush();
+                continue;
+            }
+            writer_.addSamples(samples, n);
+            samples += n;
+            count -= n;
+        }
+    }
+
+    void addCommand(std::uint8_t opcode, std::uint32_t value) {
+        if(!writer_.addCommand(opcode, value)) {
+            flush();
+            writer_.addCommand(opcode, value);
+        }
+    }
+
+    // Sends the pending frames, if any
+    void flush() {
+        std::size_t used = writer_.used();
+        if(used == 0) {
+            return;
+        }
+        transport_.transfer(buffer_.data(), nullptr, used);
+        transactions_++;
+        frames_ += writer_.frames();
+        bytes_ += used;
+        writer_.reset();
+    }
+
+    std::uint32_t nextSeq() const { return seq_; }
+    std::uint64_t transactions() const { return transactions_; }
+    std::uint64_t frames() const { return frames_; }
+    std::uint64_t bytes() const { return bytes_; }
+};
@@ -0,0 +1,59 @@
+/*
+    Single-producer single-consumer ring buffer that can live in shared memory.
+
+    Only trivially copyable items, fixed power-of-two capacity, no pointers inside, and the indexes are lock-free
+    std::atomic<std::uint32_t> so two processes mapping the same pages can use it without any syscall.
+    head and tail sit on their own cache lines so producer and consumer don't bounce one line between cores.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+template <typename T, std::uint32_t Capacity>
+struct SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "ring items are copied as plain memory");
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shared-memory rings need lock-free atomics");
+
+    static constexpr std::uint32_t capacity = Capacity;
+
+    alignas(64) std::atomic<std::uint32_t> head;    // written by the producer
+    alignas(64) std::atomic<std::uint32_t> tail;    // written by the consumer
+    alignas(64) T items[Capacity];
+
+    // Placement-init in freshly mapped memory
+    void init() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    bool push(const T &item) {
+        std::uint32_t h = head.load(std::memory_order_relaxed);
+        if(h - tail.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        std::uint32_t t = tail.load(std::memory_order_relaxed);
+        if(t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+};
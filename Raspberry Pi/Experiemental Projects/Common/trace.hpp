@@ -0,0 +1,428 @@
+/*
+    Compact binary trace of GPIO and bus traffic, so a run on the real board can be replayed later on any Linux machine.
+
+    File layout (all multi-byte header fields little-endian):
+        header : "EMTR" | u8 version | u8[3] reserved | u64 base timestamp (ns, CLOCK_MONOTONIC)
+        record : u8 type | zigzag varint time delta (ns, from the previous record) | varint source | payload
+
+    Payload per record type:
+        EdgeRising / EdgeFalling : varint line offset | varint line_seqno
+        LineValues / LineWrite   : varint mask | varint bits
+        Sample                   : varint channel | zigzag varint value
+        BusTransfer / BusWrite   : varint length | bytes
+
+    The time delta is signed because kernel edge timestamps can be older than a write that was recorded just before them.
+    A record takes 7-10 bytes, most of it the time delta (3-4 bytes for gaps of a millisecond to a minute); the
+    synthetic ultrasonic trace comes to 8 bytes per record, so a polling loop can still be recorded for minutes
+    without the file getting large.
+
+    "source" is an id picked by whoever attaches the recorder (e.g. the first line offset or a bus number), the replayer
+    uses it to hand each wrapper back its own records.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <system_error>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+enum class TraceType : std::uint8_t {
+    EdgeRising = 1,
+    EdgeFalling = 2,
+    LineValues = 3,   // result of reading input lines
+    LineWrite = 4,    // values written to output lines
+    Sample = 5,       // converted ADC sample
+    BusTransfer = 6,  // bytes received in an SPI/I2C transfer
+    BusWrite = 7,     // bytes sent on a write-only transfer
+};
+
+struct TraceRecord {
+    TraceType type;
+    std::uint64_t time_ns;
+    std::uint32_t source;
+    std::uint64_t a;            // offset / mask / channel / payload length
+    std::uint64_t b;            // line_seqno / bits / zigzag value / payload index
+};
+
+inline std::uint64_t traceNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+namespace trace_detail {
+
+inline void putVarint(std::vector<std::uint8_t> &out, std::uint64_t v) {
+    while(v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+inline std::uint64_t zigzag(std::int64_t v) {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t v) {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+// returns false when the buffer ends in the middle of a varint
+inline bool getVarint(const std::uint8_t *&p, const std::uint8_t *end, std::uint64_t &v) {
+    v = 0;
+    for(unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        std::uint8_t byte = *p++;
+        v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static constexpr char magic[4] = {'E', 'M', 'T', 'R'};
+static constexpr std::uint8_t version = 1;
+static constexpr std::size_t headerSize = 16;
+
+} // namespace trace_detail
+
+class TraceRecorder {
+private:
+    int fd_ = -1;
+    std::vector<std::uint8_t> buf_;
+    std::uint64_t last_ns_;
+    std::uint64_t records_ = 0;
+    std::uint64_t bytes_ = 0;
+    static constexpr std::size_t flushThreshold = 64 * 1024;
+
+    void begin(TraceType type, std::uint64_t time_ns, std::uint32_t source) {
+        buf_.push_back(static_cast<std::uint8_t>(type));
+        trace_detail::putVarint(buf_, trace_detail::zigzag(static_cast<std::int64_t>(time_ns - last_ns_)));
+        trace_detail::putVarint(buf_, source);
+        last_ns_ = time_ns;
+        records_++;
+    }
+
+    void end() {
+        if(buf_.size() >= flushThreshold) {
+            flush();
+        }
+    }
+
+    // Prevent copying
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+public:
+    explicit TraceRecorder(const char *path) {
+        fd_ = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd_ < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to create trace file");
+        }
+        buf_.reserve(flushThreshold * 2);
+
+        last_ns_ = traceNowNs();
+        buf_.insert(buf_.end(), trace_detail::magic, trace_detail::magic + 4);
+        buf_.push_back(trace_detail::version);
+        buf_.insert(buf_.end(), 3, 0);
+        for(int i = 0; i < 8; i++) {
+            buf_.push_back(static_cast<std::uint8_t>(last_ns_ >> (8 * i)));
+        }
+    }
+
+    ~TraceRecorder() {
+        try {
+            flush();
+        } catch(const std::exception &) {
+        }
+        close(fd_);
+    }
+
+    void edge(std::uint32_t source, std::uint64_t timestamp_ns, bool rising, std::uint32_t offset, std::uint32_t line_seqno) {
+        begin(rising ? TraceType::EdgeRising : TraceType::EdgeFalling, timestamp_ns, source);
+        trace_detail::putVarint(buf_, offset);
+        trace_detail::putVarint(buf_, line_seqno);
+        end();
+    }
+
+    void lineValues(std::uint32_t source, std::uint64_t mask, std::uint64_t bits) {
+        begin(TraceType::LineValues, traceNowNs(), source);
+        trace_detail::putVarint(buf_, mask);
+        trace_detail::putVarint(buf_, bits);
+        end();
+    }
+
+    void lineWrite(std::uint32_t source, std::uint64_t mask, std::uint64_t bits, std::uint64_t time_ns = traceNowNs()) {
+        begin(TraceType::LineWrite, time_ns, source);
+        trace_detail::putVarint(buf_, mask);
+        trace_detail::putVarint(buf_, bits);
+        end();
+    }
+
+    void sample(std::uint32_t source, std::uint32_t channel, std::int32_t value) {
+        begin(TraceType::Sample, traceNowNs(), source);
+        trace_detail::putVarint(buf_, channel);
+        trace_detail::putVarint(buf_, trace_detail::zigzag(value));
+        end();
+    }
+
+    void bus(std::uint32_t source, bool received, const std::uint8_t *data, std::size_t len) {
+        begin(received ? TraceType::BusTransfer : TraceType::BusWrite, traceNowNs(), source);
+        trace_detail::putVarint(buf_, len);
+        buf_.insert(buf_.end(), data, data + len);
+        end();
+    }
+
+    void flush() {
+        const std::uint8_t *p = buf_.data();
+        std::size_t left = buf_.size();
+        while(left > 0) {
+            ssize_t n = write(fd_, p, left);
+            if(n < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::system_category(), "Failed to write trace file");
+            }
+            p += n;
+            left -= static_cast<std::size_t>(n);
+        }
+        bytes_ += buf_.size();
+        buf_.clear();
+    }
+
+    std::uint64_t records() const { return records_; }
+    std::uint64_t bytes() const { return bytes_ + buf_.size(); }
+};
+
+enum class ReplaySpeed {
+    RealTime,       // same pacing as the recording
+    Accelerated,    // recorded gaps divided by the speed factor
+    MaxSpeed        // no waiting at all, for benchmarks
+};
+
+class TraceReplayer {
+private:
+    std::vector<TraceRecord> records_;
+    std::vector<std::uint8_t> payload_;
+    std::vector<std::pair<std::uint64_t, std::size_t>> cursors_;   // (type << 32 | source) -> next index to scan
+    ReplaySpeed speed_ = ReplaySpeed::MaxSpeed;
+    double factor_ = 1.0;
+    std::uint64_t wall_start_ns_ = 0;
+    std::uint64_t trace_start_ns_ = 0;
+    std::uint64_t trace_now_ns_ = 0;    // MaxSpeed: trace time reached by the records and timeouts so far
+    std::uint64_t replayed_ = 0;
+
+    std::size_t &cursor(TraceType type, std::uint32_t source) {
+        std::uint64_t key = (static_cast<std::uint64_t>(type) << 32) | source;
+        for(auto &c : cursors_) {
+            if(c.first == key) {
+                return c.second;
+            }
+        }
+        cursors_.emplace_back(key, 0);
+        return cursors_.back().second;
+    }
+
+    // Wall clock time a record with this timestamp is due at, for the paced speeds
+    std::uint64_t dueNs(std::uint64_t time_ns) const {
+        if(time_ns <= trace_start_ns_) {
+            return wall_start_ns_;
+        }
+        double offset_ns = static_cast<double>(time_ns - trace_start_ns_);
+        if(speed_ == ReplaySpeed::Accelerated) {
+            offset_ns /= factor_;
+        }
+        return wall_start_ns_ + static_cast<std::uint64_t>(offset_ns);
+    }
+
+    static void sleepUntil(std::uint64_t wall_ns) {
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(wall_ns / 1000000000ULL);
+        ts.tv_nsec = static_cast<long>(wall_ns % 1000000000ULL);
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+    }
+
+    void pace(const TraceRecord &rec) {
+        if(speed_ == ReplaySpeed::MaxSpeed) {
+            if(rec.time_ns > trace_now_ns_) {
+                trace_now_ns_ = rec.time_ns;
+            }
+            return;
+        }
+        if(rec.time_ns > trace_start_ns_) {
+            sleepUntil(dueNs(rec.time_ns));
+        }
+    }
+
+    void decode(const std::uint8_t *p, const std::uint8_t *end, std::uint64_t time_ns) {
+        using namespace trace_detail;
+        while(p < end) {
+            TraceRecord rec{};
+            std::uint64_t delta, source;
+            rec.type = static_cast<TraceType>(*p++);
+            if(!getVarint(p, end, delta) || !getVarint(p, end, source) || !getVarint(p, end, rec.a)) {
+                throw std::runtime_error("Truncated trace record");
+            }
+            time_ns += static_cast<std::uint64_t>(unzigzag(delta));
+            rec.time_ns = time_ns;
+            rec.source = static_cast<std::uint32_t>(source);
+
+            switch(rec.type) {
+            case TraceType::BusTransfer:
+            case TraceType::BusWrite:
+                if(static_cast<std::uint64_t>(end - p) < rec.a) {
+                    throw std::runtime_error("Truncated trace payload");
+                }
+                rec.b = payload_.size();
+                payload_.insert(payload_.end(), p, p + rec.a);
+                p += rec.a;
+                break;
+            case TraceType::EdgeRising:
+            case TraceType::EdgeFalling:
+            case TraceType::LineValues:
+            case TraceType::LineWrite:
+            case TraceType::Sample:
+                if(!getVarint(p, end, rec.b)) {
+                    throw std::runtime_error("Truncated trace record");
+                }
+                break;
+            default:
+                throw std::runtime_error("Unknown trace record type");
+            }
+            records_.push_back(rec);
+        }
+    }
+
+public:
+    explicit TraceReplayer(const char *path) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to open trace file");
+        }
+        std::vector<std::uint8_t> data;
+        std::uint8_t chunk[64 * 1024];
+        ssize_t n;
+        while((n = read(fd, chunk, sizeof(chunk))) > 0) {
+            data.insert(data.end(), chunk, chunk + n);
+        }
+        close(fd);
+        if(n < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to read trace file");
+        }
+
+        if(data.size() < trace_detail::headerSize || memcmp(data.data(), trace_detail::magic, 4) != 0
+           || data[4] != trace_detail::version) {
+            throw std::runtime_error("Not a trace file or unsupported version");
+        }
+        std::uint64_t base = 0;
+        for(int i = 0; i < 8; i++) {
+            base |= static_cast<std::uint64_t>(data[8 + i]) << (8 * i);
+        }
+        decode(data.data() + trace_detail::headerSize, data.data() + data.size(), base);
+        trace_start_ns_ = records_.empty() ? base : records_.front().time_ns;
+        start();
+    }
+
+    void setSpeed(ReplaySpeed speed, double factor = 1.0) {
+        speed_ = speed;
+        factor_ = factor > 0 ? factor : 1.0;
+    }
+
+    // Restarts the replay clock and rewinds every source to the beginning of the trace.
+    void start() {
+        cursors_.clear();
+        replayed_ = 0;
+        wall_start_ns_ = traceNowNs();
+        trace_now_ns_ = trace_start_ns_;
+    }
+
+    // Next record of the given type for one source, or nullptr at the end of the trace.
+    // Blocks until the record is due according to the replay speed.
+    const TraceRecord *next(TraceType type, std::uint32_t source) {
+        std::size_t &i = cursor(type, source);
+        while(i < records_.size() && (records_[i].type != type || records_[i].source != source)) {
+            i++;
+        }
+        if(i == records_.size()) {
+            return nullptr;
+        }
+        const TraceRecord &rec = records_[i++];
+        pace(rec);
+        replayed_++;
+        return &rec;
+    }
+
+    // Next edge of either direction for one source
+    const TraceRecord *nextEdge(std::uint32_t source) {
+        std::size_t &i = cursor(TraceType::EdgeRising, source);
+        while(i < records_.size() && !((records_[i].type == TraceType::EdgeRising || records_[i].type == TraceType::EdgeFalling)
+                                        && records_[i].source == source)) {
+            i++;
+        }
+        if(i == records_.size()) {
+            return nullptr;
+        }
+        const TraceRecord &rec = records_[i++];
+        pace(rec);
+        replayed_++;
+        return &rec;
+    }
+
+    // Peek at the time of the next edge without consuming it, used to emulate poll() timeouts.
+    bool peekEdge(std::uint32_t source, std::uint64_t &time_ns) {
+        std::size_t &i = cursor(TraceType::EdgeRising, source);
+        while(i < records_.size() && !((records_[i].type == TraceType::EdgeRising || records_[i].type == TraceType::EdgeFalling)
+                                        && records_[i].source == source)) {
+            i++;
+        }
+        if(i == records_.size()) {
+            return false;
+        }
+        time_ns = records_[i].time_ns;
+        return true;
+    }
+
+    // poll() on the recorded edges of one source: true if the next edge is due within timeout_ms (< 0 waits
+    // forever), false on timeout or at the end of the trace. The paced speeds sleep out the timeout (in wall
+    // time, so Accelerated shortens the gaps but not the timeout); MaxSpeed doesn't sleep but advances its
+    // trace clock by the timeout, so the timeouts fall where they fell in the recording.
+    bool waitEdge(std::uint32_t source, int timeout_ms) {
+        std::uint64_t time_ns;
+        if(!peekEdge(source, time_ns)) {
+            return false;
+        }
+        if(timeout_ms < 0) {
+            return true;
+        }
+        std::uint64_t timeout_ns = static_cast<std::uint64_t>(timeout_ms) * 1000000ULL;
+        if(speed_ == ReplaySpeed::MaxSpeed) {
+            if(time_ns <= trace_now_ns_ + timeout_ns) {
+                return true;
+            }
+            trace_now_ns_ += timeout_ns;
+            return false;
+        }
+        std::uint64_t deadline = traceNowNs() + timeout_ns;
+        if(dueNs(time_ns) <= deadline) {
+            return true;
+        }
+        sleepUntil(deadline);
+        return false;
+    }
+
+    const std::uint8_t *payload(const TraceRecord &rec) const { return payload_.data() + rec.b; }
+    std::size_t size() const { return records_.size(); }
+    std::uint64_t replayed() const { return replayed_; }
+    std::uint64_t durationNs() const { return records_.empty() ? 0 : records_.back().time_ns - trace_start_ns_; }
+};
@@ -0,0 +1,137 @@
+/*
+    Pulse rate meter for tachometer / flow sensor inputs.
+
+    ./pulse_rate_meter GPIO17 [GPIO27 ...]     live: prints frequency, period and duty per line every 500 ms
+    ./pulse_rate_meter --bench [kHz]           no hardware: pushes a synthetic 4-line square wave through the
+                                               meter and reports how many events per second it can handle
+
+    Lines are given by name (see Common/line_lookup.hpp), all on the same chip.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "../Common/gpio_line.hpp"
+#include "../Common/line_lookup.hpp"
+#include "../Common/frequency_meter.hpp"
+
+static constexpr std::uint64_t windowNs = 200000000;     // 200 ms sliding window
+static constexpr std::size_t batch = 256;
+// the synthetic lines are 1 us apart and 30 % high, above ~200 kHz their edges would overlap; below 10 Hz a
+// period no longer fits the window
+static constexpr double benchMinKhz = 0.01;
+static constexpr double benchMaxKhz = 200.0;
+
+void printStats(FrequencyMeter &meter, std::uint64_t now_ns) {
+    for(std::size_t i = 0; i < meter.size(); i++) {
+        PulseStats s = meter.stats(i, now_ns);
+        std::cout << "line " << meter.offset(i) << ": ";
+        if(s.valid) {
+            std::cout << std::fixed << std::setprecision(1) << s.frequency_hz << " Hz, period "
+                      << s.period_us << " us, duty " << s.duty * 100.0 << " %";
+        } else {
+            std::cout << "no signal";
+        }
+        std::cout << ", edges " << s.edges << ", dropped " << s.dropped << std::endl;
+    }
+}
+
+int bench(double khz) {
+    const std::vector<std::uint32_t> offsets = {17, 27, 22, 4};
+    FrequencyMeter meter(offsets, windowNs);
+
+    // 30 % duty square wave on every line, every 1000th event lost to exercise the gap handling
+    const std::uint64_t period = static_cast<std::uint64_t>(1e6 / khz);
+    const std::uint64_t high = period * 3 / 10;
+    const std::size_t total = 20000000;
+    std::vector<struct gpio_v2_line_event> events(batch);
+    std::uint32_t seqno[4] = {0, 0, 0, 0};
+    std::uint64_t t = 1000000000ULL, produced = 0, processed = 0;
+    std::chrono::nanoseconds busy{0};
+
+    while(produced < total) {
+        std::size_t n = 0;
+        while(n < batch) {
+            std::uint32_t line = produced % 4;
+            bool rising = (produced / 4) % 2 == 0;
+            std::uint64_t ts = t + line * 1000 + (rising ? 0 : high);
+            seqno[line]++;
+            if(produced % 1000 != 999) {
+                events[n] = {};
+                events[n].timestamp_ns = ts;
+                events[n].id = rising ? GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+                events[n].offset = offsets[line];
+                events[n].line_seqno = seqno[line];
+                n++;
+            }
+            produced++;
+            if(produced % 8 == 0) {
+                t += period;
+            }
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        meter.process(events.data(), n);
+        busy += std::chrono::steady_clock::now() - t0;
+        processed += n;
+    }
+
+    printStats(meter, t);
+    double seconds = std::chrono::duration<double>(busy).count();
+    std::cout << processed << " events in " << seconds * 1000.0 << " ms: " << processed / seconds / 1e6
+              << " M events/s (" << processed / seconds / 2 / 4 / 1000.0 << " kHz per line with 4 lines)" << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 2) {
+        std::cerr << "usage: " << argv[0] << " GPIO17 [GPIO27 ...] | --bench [kHz]" << std::endl;
+        return 1;
+    }
+    if(std::string(argv[1]) == "--bench") {
+        double khz = 50.0;
+        if(argc > 2) {
+            char *end;
+            khz = std::strtod(argv[2], &end);
+            if(end == argv[2] || *end != '\0' || !(khz >= benchMinKhz && khz <= benchMaxKhz)) {
+                std::cerr << "usage: " << argv[0] << " --bench [kHz, " << benchMinKhz << " to " << benchMaxKhz << "]"
+                          << std::endl;
+                return 1;
+            }
+        }
+        return bench(khz);
+    }
+
+    try {
+        std::vector<std::string> names(argv + 1, argv + argc);
+        std::vector<std::uint32_t> offsets;
+        std::string chip = resolveLines(names, offsets);
+
+        // the kernel queue must absorb everything that arrives while we print, 16 events per line is the default
+        GpioLines lines(chip.c_str(), offsets,
+                        GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING,
+                        "pulse rate meter", 4096 * offsets.size());
+        FrequencyMeter meter(offsets, windowNs);
+
+        struct gpio_v2_line_event events[batch];
+        auto nextPrint = std::chrono::steady_clock::now();
+        while(true) {
+            if(lines.waitEvent(100)) {
+                std::size_t n = lines.readEvents(events, batch);
+                meter.process(events, n);
+            }
+            auto now = std::chrono::steady_clock::now();
+            if(now >= nextPrint) {
+                printStats(meter, traceNowNs());
+                nextPrint = now + std::chrono::milliseconds(500);
+            }
+        }
+    } catch(const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
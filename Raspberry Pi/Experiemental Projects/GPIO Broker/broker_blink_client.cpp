@@ -0,0 +1,62 @@
+/*
+    Example broker client: blinks GPIO4 through the broker and prints button edges from GPIO17,
+    while any number of other clients (another copy of this program, a monitor) use the same lines.
+
+    ./gpio_broker --out 4 --in 17 &
+    ./broker_blink_client [name]
+*/
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+#include "gpio_broker_client.hpp"
+
+static constexpr std::uint32_t offsetLED = 4;
+static constexpr std::uint32_t offsetButton = 17;
+
+int main(int argc, char **argv) {
+    try {
+        GpioBrokerClient client(argc > 1 ? argv[1] : "blink client");
+        int led = client.outputIndex(offsetLED);
+        int button = client.inputIndex(offsetButton);
+        if(led < 0) {
+            std::cerr << "broker doesn't own GPIO " << offsetLED << std::endl;
+            return 1;
+        }
+        client.subscribe(SubscribeEdges);
+
+        std::uint64_t ledMask = 1ULL << led;
+        bool on = false;
+        auto nextToggle = std::chrono::steady_clock::now();
+        std::uint64_t writes = 0;
+        std::chrono::nanoseconds writeTime{0};
+
+        while(true) {
+            auto now = std::chrono::steady_clock::now();
+            if(now >= nextToggle) {
+                on = !on;
+                auto t0 = std::chrono::steady_clock::now();
+                client.write(ledMask, on ? ledMask : 0);
+                writeTime += std::chrono::steady_clock::now() - t0;
+                writes++;
+                nextToggle += std::chrono::milliseconds(500);
+            }
+
+            BrokerEvent ev;
+            while(client.pollEvent(ev)) {
+                if(ev.type == BrokerEventType::Edge && static_cast<int>(ev.index) == button) {
+                    std::cout << "button " << (ev.id == GPIO_V2_LINE_EVENT_RISING_EDGE ? "released" : "pressed")
+                              << " at " << ev.timestamp_ns << " ns, average write "
+                              << writeTime.count() / (writes ? writes : 1) << " ns, "
+                              << client.eventsDropped() << " events dropped" << std::endl;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    } catch(const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,466 @@
+/*
+    GPIO broker: the only process holding the line requests, every other program talks to it instead of
+    opening /dev/gpiochip0 itself, so a monitor and the control app can run side by side.
+
+    ./gpio_broker --out 4,22 --in 17,27 [--chip /dev/gpiochip0] [--socket path] [--sample-us 1000] [--idle-us 100]
+
+    Each client gets its own shared-memory block (see gpio_broker_protocol.hpp) after a Unix socket handshake. The
+    handshake never blocks the loop: new connections wait in the poll set until their hello arrives, up to 1 s.
+    Writes from all clients are drained from their command rings and merged into one mask/bits pair, so one
+    GPIO_V2_LINE_SET_VALUES_IOCTL covers everything that arrived since the last pass. Edge events are read from
+    the input request in batches and copied into every subscribed client's event ring, and the input values are
+    republished in each block on every edge and every --sample-us.
+
+    Clients never make a syscall to write or read, the broker finds new commands by polling: after activity it spins,
+    when idle it sleeps --idle-us between passes, which bounds the added write latency. --idle-us 0 spins all the time.
+
+    Writes are folded per pass as long as they don't contradict each other. A write that changes a line already
+    written in the same pass to a different value (a client's high-then-low pulse, or two clients disagreeing)
+    first sends what was collected so far, so every commanded edge reaches the pin; such a pulse is as short as
+    one ioctl.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <time.h>
+
+#include "../Common/gpio_line.hpp"
+#include "gpio_broker_protocol.hpp"
+
+static volatile std::sig_atomic_t running = 1;
+
+// Accepted connection whose hello hasn't arrived yet
+struct PendingClient {
+    int sock;
+    std::uint64_t deadline_ns;
+};
+
+struct BrokerClient {
+    int sock;
+    BrokerShm *shm;
+    std::string name;
+    bool edges;
+    bool samples;
+};
+
+class GpioBroker {
+private:
+    std::unique_ptr<GpioLines> outputs_;
+    std::unique_ptr<GpioLines> inputs_;
+    std::vector<std::uint32_t> output_offsets_;
+    std::vector<std::uint32_t> input_offsets_;
+    std::vector<BrokerClient> clients_;
+    std::vector<PendingClient> pending_;
+    int listen_fd_ = -1;
+    std::string socket_path_;
+    std::uint64_t output_bits_ = 0;
+    std::uint64_t input_bits_ = 0;
+    long long sample_ns_;
+    long long idle_ns_;
+    std::uint64_t next_sample_ns_ = 0;
+    std::uint64_t ioctls_ = 0;
+    std::uint64_t commands_ = 0;
+
+    static constexpr std::uint64_t helloTimeoutNs = 1000000000;     // a connection gets 1 s to send its hello
+    static constexpr std::size_t maxPending = 16;
+
+    void publishInputs(std::uint64_t timestamp_ns) {
+        for(auto &c : clients_) {
+            std::uint32_t seq = c.shm->input_seq.load(std::memory_order_relaxed);
+            c.shm->input_seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            c.shm->input_bits.store(input_bits_, std::memory_order_relaxed);
+            c.shm->input_timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+            c.shm->input_seq.store(seq + 2, std::memory_order_release);
+        }
+    }
+
+    void pushEvent(const BrokerEvent &ev, bool edge) {
+        for(auto &c : clients_) {
+            if(edge ? c.edges : c.samples) {
+                if(!c.shm->events.push(ev)) {
+                    c.shm->events_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    void applyOutputs(std::uint64_t mask, std::uint64_t bits) {
+        if(mask && outputs_) {
+            outputs_->setValues(mask, bits);
+            output_bits_ = bits;
+            ioctls_++;
+        }
+    }
+
+    // One pass over every client's command ring, the writes folded into as few ioctls as keep every edge: one,
+    // unless a line is written twice with different values. At most one ring's worth of commands per client and
+    // pass, a client whose head is further than that ahead of the tail is dropped
+    bool drainCommands() {
+        constexpr std::uint32_t capacity = decltype(BrokerShm::commands)::capacity;
+        const std::uint64_t valid = output_offsets_.size() == 64 ? ~0ULL : (1ULL << output_offsets_.size()) - 1;
+        std::uint64_t mask = 0;
+        std::uint64_t bits = output_bits_;
+        bool any = false;
+        std::vector<std::size_t> corrupt;
+        for(std::size_t i = 0; i < clients_.size(); i++) {
+            auto &c = clients_[i];
+            if(c.shm->commands.size() > capacity) {
+                corrupt.push_back(i);
+                continue;
+            }
+            BrokerCommand cmd;
+            std::uint64_t applied = 0;
+            while(applied < capacity && c.shm->commands.pop(cmd)) {
+                if(cmd.type == BrokerCommandType::Write) {
+                    cmd.mask &= valid;
+                    if(cmd.mask & mask & (cmd.bits ^ bits)) {
+                        applyOutputs(mask, bits);
+                        mask = 0;
+                    }
+                    mask |= cmd.mask;
+                    bits = (bits & ~cmd.mask) | (cmd.bits & cmd.mask);
+                } else if(cmd.type == BrokerCommandType::Subscribe) {
+                    c.edges = (cmd.mask & SubscribeEdges) != 0;
+                    c.samples = (cmd.mask & SubscribeSamples) != 0;
+                }
+                applied++;
+            }
+            if(applied) {
+                c.shm->commands_applied.fetch_add(applied, std::memory_order_relaxed);
+                commands_ += applied;
+                any = true;
+            }
+        }
+        for(std::size_t i = corrupt.size(); i-- > 0;) {
+            std::cerr << "client " << clients_[corrupt[i]].name << " corrupted its command ring" << std::endl;
+            dropClient(corrupt[i]);
+        }
+        applyOutputs(mask, bits);
+        return any;
+    }
+
+    void readEdges() {
+        struct gpio_v2_line_event events[64];
+        std::size_t n = inputs_->readEvents(events, 64);
+        for(std::size_t i = 0; i < n; i++) {
+            std::uint32_t index = 0;
+            while(index < input_offsets_.size() && input_offsets_[index] != events[i].offset) {
+                index++;
+            }
+            if(events[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE) {
+                input_bits_ |= 1ULL << index;
+            } else {
+                input_bits_ &= ~(1ULL << index);
+            }
+            pushEvent({BrokerEventType::Edge, index, events[i].id, events[i].line_seqno, events[i].timestamp_ns, input_bits_}, true);
+        }
+        if(n) {
+            publishInputs(events[n - 1].timestamp_ns);
+        }
+    }
+
+    void sampleInputs() {
+        std::uint64_t now = traceNowNs();
+        if(!inputs_ || sample_ns_ <= 0 || now < next_sample_ns_) {
+            return;
+        }
+        next_sample_ns_ = now + sample_ns_;
+        input_bits_ = inputs_->getValues(~0ULL);
+        publishInputs(now);
+        pushEvent({BrokerEventType::Sample, 0, 0, 0, now, input_bits_}, false);
+    }
+
+    // Takes every queued connection without waiting for anything; the hello is read later, once the socket is
+    // readable, so a client that connects and stays silent never stalls the loop
+    void acceptClients() {
+        while(true) {
+            int sock = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(sock < 0) {
+                return;
+            }
+            if(pending_.size() >= maxPending) {
+                close(sock);
+                continue;
+            }
+            pending_.push_back({sock, traceNowNs() + helloTimeoutNs});
+        }
+    }
+
+    // The socket is readable: one hello or nothing, the connection is closed either way unless it becomes a client
+    void finishHandshake(int sock) {
+        BrokerHello hello;
+        memset(&hello, 0, sizeof(hello));
+        if(recv(sock, &hello, sizeof(hello), MSG_DONTWAIT) != sizeof(hello) || hello.magic != brokerMagic) {
+            close(sock);
+            return;
+        }
+
+        BrokerWelcome welcome;
+        memset(&welcome, 0, sizeof(welcome));
+        welcome.magic = brokerMagic;
+        welcome.num_outputs = output_offsets_.size();
+        welcome.num_inputs = input_offsets_.size();
+        std::copy(output_offsets_.begin(), output_offsets_.end(), welcome.outputs);
+        std::copy(input_offsets_.begin(), input_offsets_.end(), welcome.inputs);
+
+        int shm_fd = memfd_create("gpio-broker-client", MFD_CLOEXEC);
+        void *mem = MAP_FAILED;
+        if(shm_fd >= 0 && ftruncate(shm_fd, sizeof(BrokerShm)) == 0) {
+            mem = mmap(nullptr, sizeof(BrokerShm), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+        }
+        if(mem == MAP_FAILED) {
+            welcome.status = errno;
+            send(sock, &welcome, sizeof(welcome), MSG_NOSIGNAL);
+            if(shm_fd >= 0) {
+                close(shm_fd);
+            }
+            close(sock);
+            return;
+        }
+
+        // memfd pages start zeroed, which is a valid empty state for all the atomics
+        auto *shm = static_cast<BrokerShm *>(mem);
+        shm->commands.init();
+        shm->events.init();
+        shm->magic = brokerMagic;
+
+        char control[CMSG_SPACE(sizeof(int))];
+        memset(control, 0, sizeof(control));
+        struct iovec iov = {&welcome, sizeof(welcome)};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &shm_fd, sizeof(int));
+
+        bool sent = sendmsg(sock, &msg, MSG_NOSIGNAL) == sizeof(welcome);
+        close(shm_fd);  // the mapping keeps the memory alive
+        if(!sent) {
+            munmap(shm, sizeof(BrokerShm));
+            close(sock);
+            return;
+        }
+
+        hello.name[sizeof(hello.name) - 1] = '\0';
+        clients_.push_back({sock, shm, hello.name, false, false});
+        publishInputs(traceNowNs());
+        std::cout << "client connected: " << hello.name << " (" << clients_.size() << " total)" << std::endl;
+    }
+
+    void dropClient(std::size_t i) {
+        std::cout << "client gone: " << clients_[i].name << ", "
+                  << clients_[i].shm->commands_applied.load() << " commands, "
+                  << clients_[i].shm->events_dropped.load() << " events dropped" << std::endl;
+        munmap(clients_[i].shm, sizeof(BrokerShm));
+        close(clients_[i].sock);
+        clients_.erase(clients_.begin() + i);
+    }
+
+public:
+    GpioBroker(const char *chip, const std::vector<std::uint32_t> &outputs, const std::vector<std::uint32_t> &inputs,
+               const std::string &socket_path, long sample_us, long idle_us)
+        : output_offsets_(outputs), input_offsets_(inputs), socket_path_(socket_path),
+          sample_ns_(sample_us * 1000LL), idle_ns_(idle_us * 1000LL)
+    {
+        if(!outputs.empty()) {
+            outputs_.reset(new GpioLines(chip, outputs, GPIO_V2_LINE_FLAG_OUTPUT, "gpio broker"));
+        }
+        if(!inputs.empty()) {
+            inputs_.reset(new GpioLines(chip, inputs, GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING
+                                                      | GPIO_V2_LINE_FLAG_EDGE_FALLING, "gpio broker", 1024));
+            input_bits_ = inputs_->getValues(~0ULL);
+        }
+
+        listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(listen_fd_ < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to create broker socket");
+        }
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(socket_path.c_str());
+        if(bind(listen_fd_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 || listen(listen_fd_, 16) < 0) {
+            int err = errno;
+            close(listen_fd_);
+            throw std::system_error(err, std::system_category(), "Failed to bind broker socket");
+        }
+    }
+
+    ~GpioBroker() {
+        while(!clients_.empty()) {
+            dropClient(clients_.size() - 1);
+        }
+        for(const auto &p : pending_) {
+            close(p.sock);
+        }
+        close(listen_fd_);
+        unlink(socket_path_.c_str());
+        std::cout << commands_ << " commands in " << ioctls_ << " set-values ioctls" << std::endl;
+    }
+
+    void run() {
+        std::vector<struct pollfd> fds;
+        bool busy = false;
+        while(running) {
+            busy = drainCommands();
+            sampleInputs();
+
+            fds.clear();
+            fds.push_back({listen_fd_, POLLIN, 0});
+            fds.push_back({inputs_ ? inputs_->fd() : -1, POLLIN, 0});
+            for(const auto &c : clients_) {
+                fds.push_back({c.sock, POLLIN, 0});
+            }
+            for(const auto &p : pending_) {
+                fds.push_back({p.sock, POLLIN, 0});
+            }
+
+            long long ns = busy ? 0 : idle_ns_;
+            std::uint64_t now = traceNowNs();
+            for(const auto &p : pending_) {
+                long long left = p.deadline_ns > now ? static_cast<long long>(p.deadline_ns - now) : 0;
+                ns = std::min(ns, left);
+            }
+            struct timespec timeout = {static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+            int ready = ppoll(fds.data(), fds.size(), &timeout, nullptr);
+            if(ready < 0) {
+                continue;
+            }
+            if(fds[1].revents & POLLIN) {
+                readEdges();
+            }
+            std::size_t first_pending = 2 + clients_.size();
+            for(std::size_t i = clients_.size(); i-- > 0;) {
+                // the socket carries nothing after the handshake, readable means closed
+                if(fds[2 + i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    dropClient(i);
+                }
+            }
+            now = traceNowNs();
+            for(std::size_t i = pending_.size(); i-- > 0;) {
+                short revents = fds[first_pending + i].revents;
+                int sock = pending_[i].sock;
+                if(revents & POLLIN) {
+                    pending_.erase(pending_.begin() + i);
+                    finishHandshake(sock);
+                } else if((revents & (POLLHUP | POLLERR)) || now >= pending_[i].deadline_ns) {
+                    pending_.erase(pending_.begin() + i);
+                    close(sock);
+                }
+            }
+            if(fds[0].revents & POLLIN) {
+                acceptClients();
+            }
+        }
+    }
+};
+
+// Comma separated line offsets, false on an empty list or anything that isn't a plain decimal number
+bool parseOffsets(const char *list, std::vector<std::uint32_t> &offsets) {
+    offsets.clear();
+    for(const char *p = list;;) {
+        if(*p < '0' || *p > '9') {
+            return false;   // also what strtoul would skip or accept silently: spaces, signs, an empty token
+        }
+        char *end;
+        errno = 0;
+        unsigned long offset = std::strtoul(p, &end, 10);
+        if(errno != 0 || offset > 0xFFFFFFFFUL) {
+            return false;
+        }
+        offsets.push_back(static_cast<std::uint32_t>(offset));
+        if(*end == '\0') {
+            return true;
+        }
+        if(*end != ',') {
+            return false;
+        }
+        p = end + 1;
+    }
+}
+
+int usage(const char *argv0) {
+    std::cerr << "usage: " << argv0 << " --out 4,22 --in 17,27 [--chip path] [--socket path]"
+              << " [--sample-us N] [--idle-us N]" << std::endl;
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *chip = "/dev/gpiochip0";
+    std::string socket_path = brokerSocketPath();
+    std::vector<std::uint32_t> outputs, inputs;
+    long sample_us = 1000, idle_us = 100;
+
+    for(int i = 1; i < argc; i += 2) {
+        std::string opt = argv[i];
+        if(i + 1 == argc) {
+            std::cerr << opt << " needs a value" << std::endl;
+            return usage(argv[0]);
+        }
+        if(opt == "--chip") {
+            chip = argv[i + 1];
+        } else if(opt == "--out") {
+            if(!parseOffsets(argv[i + 1], outputs)) {
+                std::cerr << "bad line offsets: " << argv[i + 1] << std::endl;
+                return usage(argv[0]);
+            }
+        } else if(opt == "--in") {
+            if(!parseOffsets(argv[i + 1], inputs)) {
+                std::cerr << "bad line offsets: " << argv[i + 1] << std::endl;
+                return usage(argv[0]);
+            }
+        } else if(opt == "--socket") {
+            socket_path = argv[i + 1];
+        } else if(opt == "--sample-us") {
+            sample_us = std::atol(argv[i + 1]);
+            if(sample_us < 0) {
+                std::cerr << "--sample-us must not be negative" << std::endl;
+                return 1;
+            }
+        } else if(opt == "--idle-us") {
+            idle_us = std::atol(argv[i + 1]);
+            if(idle_us < 0) {
+                std::cerr << "--idle-us must not be negative" << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << "unknown option " << opt << std::endl;
+            return usage(argv[0]);
+        }
+    }
+    if((outputs.empty() && inputs.empty()) || outputs.size() > brokerMaxLines || inputs.size() > brokerMaxLines) {
+        return usage(argv[0]);
+    }
+
+    std::signal(SIGINT, [](int) { running = 0; });
+    std::signal(SIGTERM, [](int) { running = 0; });
+
+    try {
+        GpioBroker broker(chip, outputs, inputs, socket_path, sample_us, idle_us);
+        std::cout << "gpio broker listening on " << socket_path << std::endl;
+        broker.run();
+    } catch(const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+    Client side of the GPIO broker. The constructor does the socket handshake and maps the shared block,
+    after that write(), inputs() and pollEvent() only touch shared memory.
+*/
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "gpio_broker_protocol.hpp"
+
+class GpioBrokerClient {
+private:
+    int sock_ = -1;
+    BrokerShm *shm_ = nullptr;
+    BrokerWelcome welcome_;
+
+    // Prevent copying
+    GpioBrokerClient(const GpioBrokerClient&) = delete;
+    GpioBrokerClient& operator=(const GpioBrokerClient&) = delete;
+
+    void fail(const char *what) {
+        int err = errno;
+        close(sock_);
+        throw std::system_error(err, std::system_category(), what);
+    }
+
+public:
+    explicit GpioBrokerClient(const char *name, const char *socket_path = brokerSocketPath()) {
+        sock_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if(sock_ < 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to create socket");
+        }
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+        if(connect(sock_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+            fail("Failed to connect to GPIO broker");
+        }
+
+        BrokerHello hello;
+        memset(&hello, 0, sizeof(hello));
+        hello.magic = brokerMagic;
+        strncpy(hello.name, name, sizeof(hello.name) - 1);
+        if(send(sock_, &hello, sizeof(hello), MSG_NOSIGNAL) != sizeof(hello)) {
+            fail("Failed to send broker handshake");
+        }
+
+        char control[CMSG_SPACE(sizeof(int))];
+        struct iovec iov = {&welcome_, sizeof(welcome_)};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if(recvmsg(sock_, &msg, MSG_CMSG_CLOEXEC) != sizeof(welcome_) || welcome_.magic != brokerMagic) {
+            fail("Bad broker handshake");
+        }
+        if(welcome_.status != 0) {
+            errno = welcome_.status;
+            fail("GPIO broker refused the client");
+        }
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        if(cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS) {
+            errno = EPROTO;
+            fail("GPIO broker sent no shared memory");
+        }
+        int shm_fd;
+        memcpy(&shm_fd, CMSG_DATA(cmsg), sizeof(int));
+        void *mem = mmap(nullptr, sizeof(BrokerShm), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+        close(shm_fd);
+        if(mem == MAP_FAILED) {
+            fail("Failed to map broker shared memory");
+        }
+        shm_ = static_cast<BrokerShm *>(mem);
+    }
+
+    ~GpioBrokerClient() {
+        munmap(shm_, sizeof(BrokerShm));
+        close(sock_);
+    }
+
+    // Index of a GPIO offset in the broker's output (or input) request, -1 if the broker doesn't own it
+    int outputIndex(std::uint32_t offset) const {
+        for(std::uint32_t i = 0; i < welcome_.num_outputs; i++) {
+            if(welcome_.outputs[i] == offset) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    int inputIndex(std::uint32_t offset) const {
+        for(std::uint32_t i = 0; i < welcome_.num_inputs; i++) {
+            if(welcome_.inputs[i] == offset) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // False when the command ring is full (broker not keeping up), nothing is written then
+    bool write(std::uint64_t mask, std::uint64_t bits) {
+        return shm_->commands.push({BrokerCommandType::Write, 0, mask, bits});
+    }
+
+    bool subscribe(std::uint64_t flags) {
+        return shm_->commands.push({BrokerCommandType::Subscribe, 0, flags, 0});
+    }
+
+    // Latest input values as published by the broker
+    std::uint64_t inputs(std::uint64_t *timestamp_ns = nullptr) const {
+        std::uint32_t seq;
+        std::uint64_t bits, ts;
+        do {
+            seq = shm_->input_seq.load(std::memory_order_acquire);
+            bits = shm_->input_bits.load(std::memory_order_relaxed);
+            ts = shm_->input_timestamp_ns.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while((seq & 1) || seq != shm_->input_seq.load(std::memory_order_relaxed));
+        if(timestamp_ns) {
+            *timestamp_ns = ts;
+        }
+        return bits;
+    }
+
+    bool pollEvent(BrokerEvent &event) {
+        return shm_->events.pop(event);
+    }
+
+    std::uint64_t eventsDropped() const { return shm_->events_dropped.load(std::memory_order_relaxed); }
+    std::uint64_t commandsApplied() const { return shm_->commands_applied.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,91 @@
+/*
+    Shared definitions between gpio_broker.cpp and gpio_broker_client.hpp.
+
+    Handshake over the Unix socket (SOCK_SEQPACKET, one message each way):
+        client -> broker : BrokerHello
+        broker -> client : BrokerWelcome + a memfd (SCM_RIGHTS) holding one BrokerShm for this client
+    The socket stays open only so the broker notices when the client goes away, all traffic after the handshake
+    goes through the rings in BrokerShm.
+
+    Lines are addressed by index in the broker's request (bit i of a mask is outputs[i] or inputs[i]),
+    the welcome message lists the offsets so clients can map their GPIO numbers.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include <linux/gpio.h>
+
+#include "../Common/spsc_ring.hpp"
+
+static constexpr const char *brokerDefaultSocket = "/run/gpio-broker.sock";
+static constexpr std::uint32_t brokerMagic = 0x47425231;   // "GBR1"
+static constexpr std::uint32_t brokerMaxLines = 64;
+
+inline const char *brokerSocketPath() {
+    const char *path = getenv("GPIO_BROKER_SOCKET");
+    return path && *path ? path : brokerDefaultSocket;
+}
+
+struct BrokerHello {
+    std::uint32_t magic;
+    char name[32];
+};
+
+struct BrokerWelcome {
+    std::uint32_t magic;
+    std::int32_t status;            // 0 or an errno value
+    std::uint32_t num_outputs;
+    std::uint32_t num_inputs;
+    std::uint32_t outputs[brokerMaxLines];
+    std::uint32_t inputs[brokerMaxLines];
+};
+
+enum class BrokerCommandType : std::uint32_t {
+    Write = 1,          // set output bits under mask
+    Subscribe = 2,      // mask = BrokerSubscribe flags
+};
+
+enum BrokerSubscribe : std::uint64_t {
+    SubscribeEdges = 1,
+    SubscribeSamples = 2,
+};
+
+struct BrokerCommand {
+    BrokerCommandType type;
+    std::uint32_t reserved;
+    std::uint64_t mask;
+    std::uint64_t bits;
+};
+
+enum class BrokerEventType : std::uint32_t {
+    Edge = 1,           // index, id (GPIO_V2_LINE_EVENT_*), line_seqno, timestamp
+    Sample = 2,         // bits holds all input values, timestamp when read
+};
+
+struct BrokerEvent {
+    BrokerEventType type;
+    std::uint32_t index;
+    std::uint32_t id;
+    std::uint32_t line_seqno;
+    std::uint64_t timestamp_ns;
+    std::uint64_t bits;
+};
+
+struct BrokerShm {
+    std::uint32_t magic;
+
+    // latest input values, published with a seqlock: odd sequence means the broker is writing
+    alignas(64) std::atomic<std::uint32_t> input_seq;
+    std::atomic<std::uint64_t> input_bits;
+    std::atomic<std::uint64_t> input_timestamp_ns;
+
+    alignas(64) std::atomic<std::uint64_t> events_dropped;     // broker couldn't push because the client was slow
+    std::atomic<std::uint64_t> commands_applied;
+
+    SpscRing<BrokerCommand, 1024> commands;     // client -> broker
+    SpscRing<BrokerEvent, 4096> events;         // broker -> client
+};
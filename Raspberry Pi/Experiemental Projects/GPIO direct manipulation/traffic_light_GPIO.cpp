@@ -8,6 +8,8 @@
 #include <linux/gpio.h>
 #include <sys/ioctl.h>
 
+#include "../../../Shared/deadline_monitor.hpp"
+
 std::uint16_t fd;
 struct gpio_v2_line_request req_line;
 
@@ -56,14 +58,20 @@ void close_GPIO_fd() {
 int main() {
     auto pins = std::vector<std::uint8_t> {4,17,27};   
     init_GPIO_fd("/dev/gpiochip0",pins);
-    
-    while(1) {	
-        set_GPIO_value({1,0,0});
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        set_GPIO_value({0,1,0});
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        set_GPIO_value({0,0,1});
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // kill -USR1 <pid> prints the actual light periods and overruns
+    DeadlineMonitor::enableReportTrigger();
+    DeadlineMonitor monitor("traffic light", 500000);
+    const std::vector<std::uint8_t> phases[] = {{1,0,0}, {0,1,0}, {0,0,1}};
+
+    while(1) {
+        for(const auto &phase : phases) {
+            monitor.start();
+            set_GPIO_value(phase);
+            monitor.finish();
+            DeadlineMonitor::reportIfRequested();
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
     }
 
     close_GPIO_fd();	
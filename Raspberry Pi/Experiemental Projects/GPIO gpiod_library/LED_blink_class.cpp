@@ -4,6 +4,8 @@
 #include <thread>
 #include <stdexcept>
 
+#include "../Common/rt_profile.hpp"
+
 class LEDblinkTest 
 {
 private:
@@ -65,9 +67,12 @@ public:
     }
 };
 
-int main() 
+int main(int argc, char **argv) 
 {
     try {
+        if (rtRequested(argc, argv)) {
+            applyRtProfile();
+        }
         LEDblinkTest ledBlinker;
         ledBlinker.blinkContinuously();
     } catch (const std::exception& e) {
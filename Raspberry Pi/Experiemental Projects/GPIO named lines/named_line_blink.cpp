@@ -0,0 +1,69 @@
+/*
+    Blink LEDs picked by line name, so the same binary works on a Pi 4 (header on gpiochip0) and a Pi 5
+    (header on another chip) without editing the chip path or offsets.
+
+    ./named_line_blink                 blinks GPIO4
+    ./named_line_blink GPIO4 GPIO17    blinks several lines together
+    ./named_line_blink --list          prints the index and how long a full scan vs. a cached lookup takes
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+#include "../Common/line_lookup.hpp"
+#include "../Common/gpio_line.hpp"
+
+int listLines() {
+    auto t0 = std::chrono::steady_clock::now();
+    LineIndex scanned = LineIndex::scan();
+    auto t1 = std::chrono::steady_clock::now();
+    scanned.save(defaultLineCachePath(), kernelBootId());
+    LineIndex cached = LineIndex::open();
+    auto t2 = std::chrono::steady_clock::now();
+
+    for(const auto &line : scanned.lines()) {
+        std::cout << line.name << "\t" << line.chip << "\t" << line.offset << std::endl;
+    }
+    std::cout << scanned.lines().size() << " named lines, scan "
+              << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us, cache "
+              << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() << " us"
+              << (cached.fromCache() ? "" : " (cache not used)") << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    try {
+        if(argc > 1 && std::string(argv[1]) == "--list") {
+            return listLines();
+        }
+
+        std::vector<std::string> names;
+        for(int i = 1; i < argc; i++) {
+            names.push_back(argv[i]);
+        }
+        if(names.empty()) {
+            names.push_back("GPIO4");
+        }
+
+        std::vector<std::uint32_t> offsets;
+        std::string chip = resolveLines(names, offsets);
+        std::cout << names[0] << " is " << chip << " offset " << offsets[0] << std::endl;
+
+        GpioLines leds(chip.c_str(), offsets, GPIO_V2_LINE_FLAG_OUTPUT, "named led blink");
+        std::uint64_t all = offsets.size() == 64 ? ~0ULL : (1ULL << offsets.size()) - 1;
+        while(true) {
+            leds.setValues(all, all);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            leds.setValues(all, 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(900));
+        }
+    } catch(const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
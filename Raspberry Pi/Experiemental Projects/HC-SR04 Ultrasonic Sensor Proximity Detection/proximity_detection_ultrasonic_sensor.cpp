@@ -10,15 +10,22 @@
 #include <chrono>
 #include <thread>
 
+#include "../Common/rt_profile.hpp"
+#include "../Common/precision_sleep.hpp"
+
 const char *pathname = "/dev/gpiochip0";
 static constexpr auto offsetOutTrigger = std::uint8_t {4};
 static constexpr auto offsetInEcho = std::uint8_t {27};
 static constexpr auto offsetLED = std::uint8_t{22};
 const std::string consumer = "ultrasonic sensor";
 
-int main() {
+int main(int argc, char **argv) {
     
     try {
+        // --rt: locked memory, isolated CPU and SCHED_FIFO so the 10us sleeps aren't stretched by other tasks
+        if(rtRequested(argc, argv)) {
+            applyRtProfile();
+        }
 
         gpiod::chip chip(pathname);	
         
@@ -35,10 +42,11 @@ int main() {
 	    while(1) {
             std::uint64_t count = 0;
             
+            // sleep_for(10us) used to give 60-100 us pulses, waits this short are spun on the cycle counter
             outLine.set_value(1);
-            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            PrecisionSleep::waitFor(std::chrono::microseconds(10));
             outLine.set_value(0);
-            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            PrecisionSleep::waitFor(std::chrono::microseconds(10));
 	
 	// inner while loop is for processing recieved signal from 1st while loop
 	    while(1) {
@@ -0,0 +1,128 @@
+/*
+    Hardware-timed PWM from a PCA9685 board on /dev/i2c-1 (address 0x40), one I2C transaction per update.
+
+    ./pca9685_pwm servo [--scurve] [--rt] [servos]     servos on channels 0.. (default 1) cycling 0 -> 90 -> 180 -> 90
+                                                       degrees with the motion planner from SG90 Servo Motor, 50 Hz
+    ./pca9685_pwm led [channel]                        LED ramping up and down in equal steps of perceived
+                                                       brightness like the MCP41010 demo (Shared/brightness.hpp
+                                                       gamma table over 4096 counts), 1 kHz PWM
+
+    Compared to servo_motion.cpp the Pi only has to hand over the widths once per frame, a late wake-up delays
+    the next position by a few ms but never stretches a pulse. The servo mode prints how long the bus
+    transaction takes every 5 s.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+#include "../Common/i2c_device.hpp"
+#include "../Common/pca9685.hpp"
+#include "../Common/rt_profile.hpp"
+#include "../Common/clock.hpp"
+#include "../SG90 Servo Motor/servo_planner.hpp"
+#include "../../../Shared/brightness.hpp"
+
+const char *i2cBus = "/dev/i2c-1";
+const float positions[] = {0, 90, 180, 90};
+const std::uint64_t holdFrames = 50;
+
+// Records how long each bus transaction took
+struct TimedOutput {
+    Pca9685 &pca;
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds worst{0};
+
+    void writeFrame(const std::uint16_t *widths, std::size_t count, SteadyClock::time_point start) {
+        auto t0 = std::chrono::steady_clock::now();
+        pca.writeFrame(widths, count, start);
+        auto took = std::chrono::steady_clock::now() - t0;
+        total += took;
+        worst = std::max<std::chrono::nanoseconds>(worst, took);
+    }
+};
+
+int runServos(I2cDevice &i2c, std::size_t servos, MotionProfile profile) {
+    Pca9685 pca(i2c, 50);
+    ServoPlanner planner(servos, ServoLimits(), profile);
+    TimedOutput output{pca};
+    ServoMotion<SteadyClock, TimedOutput> motion(planner, output);
+
+    std::vector<std::size_t> step(servos, 0);
+    std::vector<std::uint64_t> holding(servos, holdFrames);
+    std::uint64_t frames = 0;
+    auto report = std::chrono::steady_clock::now();
+    while(true) {
+        motion.runFrames(1);
+        frames++;
+        for(std::size_t c = 0; c < servos; c++) {
+            if(planner.axis(c).settled() && holding[c]++ >= holdFrames) {
+                planner.moveTo(c, positions[step[c]]);
+                step[c] = (step[c] + 1) % (sizeof(positions) / sizeof(positions[0]));
+                holding[c] = 0;
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if(now - report >= std::chrono::seconds(5)) {
+            std::cout << frames << " frames at " << pca.frequency() << " Hz, " << pca.transactions()
+                      << " I2C transactions, mean " << output.total.count() / 1000.0 / frames << " us, worst "
+                      << output.worst.count() / 1000.0 << " us" << std::endl;
+            report = now;
+        }
+    }
+    return 0;
+}
+
+int runLed(I2cDevice &i2c, std::size_t channel) {
+    Pca9685 pca(i2c, 1000);
+    Pca9685Channel led(pca, channel);
+    BrightnessController<Pca9685Channel> brightness(led, 255, 0, 0, 2.2f, 1);
+    while(true) {
+        for(int level = 0; level <= 255; level += 5) {
+            brightness.setLevel(static_cast<std::uint8_t>(level));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        for(int level = 250; level > 0; level -= 5) {
+            brightness.setLevel(static_cast<std::uint8_t>(level));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if(mode != "servo" && mode != "led") {
+        std::cerr << "usage: " << argv[0] << " servo [--scurve] [--rt] [servos] | led [channel]" << std::endl;
+        return 1;
+    }
+
+    try {
+        MotionProfile profile = MotionProfile::Trapezoidal;
+        std::size_t number = mode == "servo" ? 1 : 0;
+        for(int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if(arg == "--scurve") {
+                profile = MotionProfile::SCurve;
+            } else if(arg[0] != '-') {
+                number = std::strtoul(argv[i], nullptr, 10);
+            }
+        }
+        if(rtRequested(argc, argv)) {
+            applyRtProfile();
+        }
+
+        I2cDevice i2c(i2cBus, Pca9685::defaultAddress);
+        if(mode == "servo") {
+            return runServos(i2c, std::min(std::max<std::size_t>(number, 1), Pca9685::channels), profile);
+        }
+        return runLed(i2c, number % Pca9685::channels);
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,77 @@
+/*
+    Overshoot distribution of each wait strategy in Common/precision_sleep.hpp on this machine,
+    for the wait lengths the demos use (10 us trigger pulse, 500/1500/2500 us servo pulses).
+
+    ./precision_sleep_benchmark [iterations] [--rt]
+
+    Overshoot = wake-up time - deadline, measured with CLOCK_MONOTONIC. Try it with and without --rt and
+    with some background load, the Nanosleep rows are what std::this_thread::sleep_for() gives today.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#include "../Common/precision_sleep.hpp"
+#include "../Common/rt_profile.hpp"
+
+void run(const char *name, WaitStrategy strategy, long wait_us, int iterations) {
+    std::vector<std::int64_t> over(iterations);
+    for(auto &o : over) {
+        std::uint64_t deadline = CycleCounter::nowNs() + wait_us * 1000;
+        PrecisionSleep::waitUntil(deadline, strategy);
+        o = static_cast<std::int64_t>(CycleCounter::nowNs() - deadline);
+    }
+    std::sort(over.begin(), over.end());
+    auto pct = [&](double p) { return over[static_cast<std::size_t>(p * (over.size() - 1))] / 1000.0; };
+    std::cout << std::left << std::setw(11) << name << std::right << std::setw(6) << wait_us << " us"
+              << std::fixed << std::setprecision(2)
+              << "  min " << std::setw(8) << pct(0.0)
+              << "  p50 " << std::setw(8) << pct(0.5)
+              << "  p90 " << std::setw(8) << pct(0.9)
+              << "  p99 " << std::setw(8) << pct(0.99)
+              << "  max " << std::setw(8) << pct(1.0) << "  (us late)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 && std::string(argv[1]) != "--rt" ? std::atoi(argv[1]) : 2000;
+    if(iterations <= 0) {
+        std::cerr << "usage: " << argv[0] << " [iterations, at least 1] [--rt]" << std::endl;
+        return 1;
+    }
+    if(rtRequested(argc, argv)) {
+        try {
+            applyRtProfile();
+        } catch(const std::exception &e) {
+            std::cerr << "Failed to apply real-time profile: " << e.what() << std::endl;
+        }
+    }
+
+    std::cout << "cycle counter: " << CycleCounter::name() << ", " << CycleCounter::ticksPerNs() * 1000.0
+              << " ticks/us" << std::endl;
+    const long waits[] = {10, 100, 500, 1500, 2500};
+    const struct {
+        const char *name;
+        WaitStrategy strategy;
+    } strategies[] = {
+        {"Nanosleep", WaitStrategy::Nanosleep},
+        {"SlackTuned", WaitStrategy::SlackTuned},
+        {"Spin", WaitStrategy::Spin},
+        {"Hybrid", WaitStrategy::Hybrid},
+    };
+
+    // Nanosleep rows first: every other strategy drops this thread's timer slack, which can't be told apart later
+    for(long w : waits) {
+        run(strategies[0].name, strategies[0].strategy, w, iterations);
+    }
+    std::cout << "calibrated spin margin: " << PrecisionSleep::calibrate() / 1000.0 << " us" << std::endl;
+    for(int s = 1; s < 4; s++) {
+        for(long w : waits) {
+            run(strategies[s].name, strategies[s].strategy, w, iterations);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+    Wake-up latency self-test for the real-time profile in Common/rt_profile.hpp.
+
+    A measuring thread sleeps with clock_nanosleep(TIMER_ABSTIME) on a 1 ms period and records how late it woke up,
+    while load threads keep every CPU busy and a memory hog keeps allocating and touching fresh pages.
+    The test runs once as a normal SCHED_OTHER thread and once with applyRtProfile(), then prints both distributions.
+
+    ./rt_latency_selftest [seconds per phase] [load threads]
+    Run as root (or with CAP_SYS_NICE + CAP_IPC_LOCK), otherwise the second phase reports the error and stops.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+#include <time.h>
+
+#include "../Common/rt_profile.hpp"
+#include "../Common/probes.hpp"
+
+static constexpr long periodNs = 1000000;
+
+std::atomic<bool> stopLoad{false};
+
+void cpuHog() {
+    volatile std::uint64_t x = 0;
+    while(!stopLoad.load(std::memory_order_relaxed)) {
+        x = x + 1;
+    }
+}
+
+void memoryHog() {
+    long page = sysconf(_SC_PAGESIZE);
+    while(!stopLoad.load(std::memory_order_relaxed)) {
+        std::size_t size = 32 * 1024 * 1024;
+        auto *p = static_cast<volatile char *>(mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if(p == MAP_FAILED) {
+            continue;
+        }
+        for(std::size_t i = 0; i < size; i += page) {
+            p[i] = 1;
+        }
+        munmap(const_cast<char *>(p), size);
+    }
+}
+
+void addNs(struct timespec &ts, long ns) {
+    ts.tv_nsec += ns;
+    while(ts.tv_nsec >= 1000000000L) {
+        ts.tv_nsec -= 1000000000L;
+        ts.tv_sec++;
+    }
+}
+
+// latencies in ns, vector is sized up front so the loop itself never allocates
+std::vector<long> measure(int seconds) {
+    std::vector<long> lat(static_cast<std::size_t>(seconds) * (1000000000L / periodNs));
+    struct timespec next, now;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for(auto &l : lat) {
+        addNs(next, periodNs);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        l = (now.tv_sec - next.tv_sec) * 1000000000L + (now.tv_nsec - next.tv_nsec);
+        // a wake-up later than one whole period counts as a missed deadline
+        if(l < periodNs) {
+            EMB_PROBE2(deadline_hit, 0, l);
+        } else {
+            EMB_PROBE2(deadline_miss, 0, l);
+        }
+    }
+    return lat;
+}
+
+void report(const char *name, std::vector<long> lat) {
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double p) { return lat[static_cast<std::size_t>(p * (lat.size() - 1))] / 1000.0; };
+    long long sum = 0;
+    for(long l : lat) {
+        sum += l;
+    }
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+              << " min " << std::setw(8) << pct(0.0)
+              << " avg " << std::setw(8) << sum / 1000.0 / lat.size()
+              << " p50 " << std::setw(8) << pct(0.5)
+              << " p99 " << std::setw(8) << pct(0.99)
+              << " p99.9 " << std::setw(8) << pct(0.999)
+              << " max " << std::setw(8) << pct(1.0) << "  (us)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    int seconds = argc > 1 ? std::atoi(argv[1]) : 10;
+    int loadThreads = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+    if(seconds <= 0 || loadThreads < 0) {
+        std::cerr << "usage: " << argv[0] << " [seconds per phase, at least 1] [load threads]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::thread> load;
+    for(int i = 0; i < loadThreads; i++) {
+        load.emplace_back(cpuHog);
+    }
+    load.emplace_back(memoryHog);
+
+    std::cout << "wake-up latency, " << periodNs / 1000 << " us period, " << seconds << " s per phase, "
+              << loadThreads << " CPU hogs + 1 memory hog" << std::endl;
+
+    std::vector<long> normal, rt;
+    std::thread([&] { normal = measure(seconds); }).join();
+    report("SCHED_OTHER", normal);
+
+    int isolated = isolatedCpu();
+    std::cout << "isolated cpu: " << (isolated >= 0 ? std::to_string(isolated) : std::string("none")) << std::endl;
+    std::thread([&] {
+        try {
+            applyRtProfile();
+            rt = measure(seconds);
+        } catch(const std::exception &e) {
+            std::cerr << "Failed to apply real-time profile: " << e.what() << std::endl;
+        }
+    }).join();
+    if(!rt.empty()) {
+        report("rt profile", rt);
+    }
+
+    stopLoad = true;
+    for(auto &t : load) {
+        t.join();
+    }
+    return rt.empty() ? 1 : 0;
+}
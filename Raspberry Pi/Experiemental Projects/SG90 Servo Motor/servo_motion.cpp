@@ -0,0 +1,93 @@
+/*
+    Up to 16 SG90s on one 20 ms frame, moved by servo_planner.hpp: every channel cycles 0 -> 90 -> 180 -> 90
+    degrees with a speed / acceleration limited trajectory, staggered so they don't all move together, and holds
+    each position for a second.
+
+    ./servo_motion [--scurve] [--rt] [offset ...]      default: one servo on GPIO 4
+
+    All lines are requested together, one write raises them and they are dropped in order of pulse width
+    (at most 17 writes per frame). Prints frames, writes, deadline misses and the worst late edge every 5 s,
+    the deadline_hit / deadline_miss probes have the per-channel detail (see Common/probes.hpp).
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "../Common/gpio_line.hpp"
+#include "../Common/rt_profile.hpp"
+#include "../Common/precision_sleep.hpp"
+#include "../Common/clock.hpp"
+#include "servo_planner.hpp"
+
+const char *pathname = "/dev/gpiochip0";
+const char *consumer = "servo motion";
+const float positions[] = {0, 90, 180, 90};
+const std::uint64_t holdFrames = 50;
+
+int main(int argc, char **argv) {
+    try {
+        MotionProfile profile = MotionProfile::Trapezoidal;
+        std::vector<std::uint32_t> offsets;
+        for(int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if(arg == "--scurve") {
+                profile = MotionProfile::SCurve;
+            } else if(arg[0] != '-') {
+                offsets.push_back(static_cast<std::uint32_t>(std::atoi(argv[i])));
+            }
+        }
+        if(offsets.empty()) {
+            offsets.push_back(4);
+        }
+        if(offsets.size() > ServoPlanner::maxChannels) {
+            offsets.resize(ServoPlanner::maxChannels);
+        }
+        if(rtRequested(argc, argv)) {
+            applyRtProfile();
+        }
+
+        GpioLines lines(pathname, offsets, GPIO_V2_LINE_FLAG_OUTPUT, consumer);
+        PrecisionSleep::calibrate();
+        ServoPlanner planner(offsets.size(), ServoLimits(), profile);
+        GpioPulseOutput<PrecisionClock, GpioLines> output(lines);
+        ServoMotion<PrecisionClock, GpioPulseOutput<PrecisionClock, GpioLines>> motion(planner, output);
+
+        std::vector<std::size_t> step(offsets.size(), 0);
+        std::vector<std::uint64_t> holding(offsets.size(), 0);
+        for(std::size_t c = 0; c < offsets.size(); c++) {
+            // four groups starting a quarter second apart, so the pulse widths differ within a frame
+            holding[c] = holdFrames - c % 4 * 12;
+        }
+
+        std::uint64_t frames = 0;
+        auto report = std::chrono::steady_clock::now();
+        while(true) {
+            motion.runFrames(1);
+            frames++;
+            for(std::size_t c = 0; c < offsets.size(); c++) {
+                if(!planner.axis(c).settled()) {
+                    continue;
+                }
+                if(holding[c]++ >= holdFrames) {
+                    planner.moveTo(c, positions[step[c]]);
+                    step[c] = (step[c] + 1) % (sizeof(positions) / sizeof(positions[0]));
+                    holding[c] = 0;
+                }
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if(now - report >= std::chrono::seconds(5)) {
+                std::cout << frames << " frames, " << output.writes() << " writes, " << output.misses()
+                          << " misses, worst late edge " << output.worstLateness().count() / 1000.0 << " us" << std::endl;
+                report = now;
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
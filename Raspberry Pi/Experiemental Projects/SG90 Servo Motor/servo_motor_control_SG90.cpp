@@ -3,42 +3,31 @@
 #include <chrono>
 #include <thread>
 
+#include "../Common/rt_profile.hpp"
+#include "../Common/precision_sleep.hpp"
+#include "servo_sweep.hpp"
+
 static constexpr auto offsetpwm = std::uint8_t {4};
 const char *pathname = "/dev/gpiochip0";
 const auto consumer = std::string("servo sg90");
 
-int main() {
+int main(int argc, char **argv) {
 
     try {
+        // ./servo_motor_control_SG90 --rt locks memory, pins to an isolated CPU and runs SCHED_FIFO
+        if(rtRequested(argc, argv)) {
+            applyRtProfile();
+        }
+
         gpiod::chip chip(pathname);	
         gpiod::line pwmpin = chip.get_line(offsetpwm);
         pwmpin.request({consumer,gpiod::line_request::DIRECTION_OUTPUT});
 
-        while(1) {
-            auto count = std::uint64_t {0};
-            while(1) {
-                count++;
-                if(count < 700) {
-                    pwmpin.set_value(1);
-                    std::this_thread::sleep_for(std::chrono::microseconds(500)); 
-                    pwmpin.set_value(0);
-                } else if(count < 1400) {
-                    pwmpin.set_value(1);
-                    std::this_thread::sleep_for(std::chrono::microseconds(1500));
-                    pwmpin.set_value(0);
-                } else {
-                    pwmpin.set_value(1);
-                    std::this_thread::sleep_for(std::chrono::microseconds(2500));
-                    pwmpin.set_value(0);
-                }
-                if(count >= 2100) {
-                    count = 0;
-                }
-                std::this_thread::sleep_for(std::chrono::microseconds(500));
-            }
-
-            std::this_thread::sleep_for(std::chrono::milliseconds(20));
-        }
+        // 500/1500/2500 us pulses, see servo_sweep.hpp (servo_sweep_virtual.cpp runs the same loop on a virtual clock).
+        // sleep_for overshot the pulses by 50-100 us, PrecisionClock sleeps most of the way and spins the rest.
+        PrecisionSleep::calibrate();
+        ServoSweep<PrecisionClock, gpiod::line> sweep(pwmpin);
+        sweep.runForever();
 
     } catch(std::exception& e) {
 	    std::cout << e.what();
@@ -0,0 +1,291 @@
+/*
+    Motion planning for up to 16 hobby servos, one 20 ms frame at a time.
+
+    ServoPlanner holds one trajectory per channel. Each frame advance() moves every channel towards its target
+    under a speed and acceleration limit (trapezoidal velocity) and hands out the pulse width for the frame.
+    Targets can change at any time, also in the middle of a move: the trajectory is followed online from the
+    current position and step, braking so it stops on the target. The S-curve profile is the same trajectory
+    averaged over max_accel / max_jerk seconds, which turns each acceleration step into a ramp (bounded jerk)
+    and still ends exactly on the target, one ramp later.
+
+    GpioPulseOutput turns a frame of pulse widths into edges on GPIO lines requested together (GpioLines):
+    the channels are sorted by pulse width, one multi-line write raises all of them, then each line is dropped
+    at its own deadline, channels ending at the same microsecond share a write. At most 17 writes per frame
+    instead of a rise and fall with two sleeps per servo, and all pulses start at the same instant.
+    Each fall is reported to the deadline_hit / deadline_miss probes (id = channel) with its lateness.
+
+    ServoMotion runs planner + output on absolute 20 ms deadlines. Clock is a policy from Common/clock.hpp
+    (PrecisionClock on hardware, VirtualClock in servo_planner_virtual.cpp); Output needs
+    writeFrame(widths_us, count, frame_start), so Pca9685 from Common/pca9685.hpp can stand in for the GPIO lines.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <array>
+
+#include "../Common/probes.hpp"
+
+enum class MotionProfile {
+    Trapezoidal,
+    SCurve
+};
+
+struct ServoLimits {
+    float min_us = 500;             // pulse for 0 degrees
+    float max_us = 2500;            // pulse for 180 degrees
+    float max_speed = 300;          // deg/s, the SG90 does ~600 unloaded
+    float max_accel = 1500;         // deg/s^2
+    float max_jerk = 15000;         // deg/s^3, S-curve only
+};
+
+class ServoTrajectory {
+private:
+    static constexpr std::size_t maxSmoothing = 16;
+
+    // trapezoidal trajectory, worked in steps per frame so the limits hold exactly for what the servo sees
+    float position_ = 90;
+    float step_ = 0;
+    float target_ = 90;
+    float output_ = 90;             // what the servo gets, position_ or its S-curve average
+    float output_velocity_ = 0;
+    std::array<float, maxSmoothing> history_;
+    std::size_t head_ = 0;
+    std::uint32_t end_stops_ = 0;
+
+    // Largest step this frame that can still brake to a stop on the target, one frame step change u at a time:
+    // s + (s - u) + (s - 2u) + ... ~ s^2 / 2u + s / 2 <= distance
+    static float stoppingStep(float distance, float u) {
+        return u * (std::sqrt(0.25f + 2 * distance / u) - 0.5f);
+    }
+
+public:
+    ServoTrajectory() { history_.fill(position_); }
+
+    void moveTo(float degrees) { target_ = std::min(180.0f, std::max(0.0f, degrees)); }
+
+    // Jumps there without a trajectory, e.g. to match the position the servo was left at
+    void reset(float degrees) {
+        position_ = target_ = output_ = std::min(180.0f, std::max(0.0f, degrees));
+        step_ = output_velocity_ = 0;
+        history_.fill(position_);
+    }
+
+    void advance(float dt, const ServoLimits &l, MotionProfile profile) {
+        const float u = l.max_accel * dt * dt;
+        float error = target_ - position_;
+        if(std::abs(error) <= u && std::abs(error - step_) <= u) {
+            // the last step, and stopping after it, are both within the acceleration limit; settled one frame later
+            position_ = target_;
+            step_ = error;
+        } else if(error != 0 || step_ != 0) {
+            // a target that moved closer than the braking distance is overshot and approached from the other side
+            float dir = error > 0 ? 1.0f : -1.0f;
+            float wanted = dir * std::min(l.max_speed * dt, stoppingStep(std::abs(error), u));
+            float step = step_ + std::min(u, std::max(-u, wanted - step_));
+            // an overshoot can run into an end stop, the horn stops there whatever the acceleration
+            float next = std::min(180.0f, std::max(0.0f, position_ + step));
+            if(next != position_ + step) {
+                end_stops_++;
+            }
+            step_ = next - position_;
+            position_ = next;
+        }
+
+        history_[head_] = position_;
+        head_ = (head_ + 1) % maxSmoothing;
+        float previous = output_;
+        if(profile == MotionProfile::SCurve) {
+            // averaging over ramp seconds turns every acceleration step into a linear ramp with jerk accel / ramp
+            std::size_t n = static_cast<std::size_t>(std::lround(l.max_accel / l.max_jerk / dt));
+            n = std::min(maxSmoothing, std::max<std::size_t>(1, n));
+            float sum = 0;
+            for(std::size_t i = 1; i <= n; i++) {
+                sum += history_[(head_ + maxSmoothing - i) % maxSmoothing];
+            }
+            output_ = sum / n;
+            if(std::abs(output_ - position_) < 1e-4f && step_ == 0) {
+                output_ = position_;
+            }
+        } else {
+            output_ = position_;
+        }
+        output_velocity_ = (output_ - previous) / dt;
+    }
+
+    float position() const { return output_; }
+    float velocity() const { return output_velocity_; }
+    float target() const { return target_; }
+    bool settled() const { return output_ == target_ && position_ == target_ && step_ == 0; }
+    // frames where an overshoot was cut off at 0 or 180 degrees
+    std::uint32_t endStops() const { return end_stops_; }
+};
+
+class ServoPlanner {
+public:
+    static constexpr std::size_t maxChannels = 16;
+
+private:
+    std::size_t channels_;
+    ServoLimits limits_;
+    MotionProfile profile_;
+    std::array<ServoTrajectory, maxChannels> axes_;
+    std::array<std::uint16_t, maxChannels> widths_{};
+
+public:
+    ServoPlanner(std::size_t channels, const ServoLimits &limits = ServoLimits(),
+                 MotionProfile profile = MotionProfile::Trapezoidal)
+        : channels_(std::min(channels, maxChannels)), limits_(limits), profile_(profile)
+    {
+        for(std::size_t i = 0; i < channels_; i++) {
+            widths_[i] = pulseWidth(axes_[i].position());
+        }
+    }
+
+    void moveTo(std::size_t channel, float degrees) { axes_[channel].moveTo(degrees); }
+    void reset(std::size_t channel, float degrees) { axes_[channel].reset(degrees); }
+    void setProfile(MotionProfile profile) { profile_ = profile; }
+
+    std::uint16_t pulseWidth(float degrees) const {
+        return static_cast<std::uint16_t>(std::lround(limits_.min_us + (limits_.max_us - limits_.min_us) * degrees / 180.0f));
+    }
+
+    // Moves every channel by one frame and returns the pulse widths (us) for it
+    const std::uint16_t *advance(std::chrono::microseconds frame) {
+        float dt = frame.count() * 1e-6f;
+        for(std::size_t i = 0; i < channels_; i++) {
+            axes_[i].advance(dt, limits_, profile_);
+            widths_[i] = pulseWidth(axes_[i].position());
+        }
+        return widths_.data();
+    }
+
+    bool settled() const {
+        for(std::size_t i = 0; i < channels_; i++) {
+            if(!axes_[i].settled()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const ServoTrajectory &axis(std::size_t channel) const { return axes_[channel]; }
+    const std::uint16_t *widths() const { return widths_.data(); }
+    std::size_t channels() const { return channels_; }
+};
+
+// Lines needs setValues(mask, bits) with bit i = channel i (GpioLines, or a recording stand-in in tests)
+template <typename Clock, typename Lines>
+class GpioPulseOutput {
+private:
+    Lines &lines_;
+    std::chrono::nanoseconds miss_tolerance_;
+    std::array<std::uint8_t, ServoPlanner::maxChannels> order_{};
+    std::size_t ordered_ = 0;
+    std::uint64_t writes_ = 0;
+    std::uint64_t misses_ = 0;
+    std::chrono::nanoseconds worst_lateness_{0};
+
+public:
+    // a fall more than miss_tolerance late is reported as a deadline miss (20 us is ~2 degrees on an SG90)
+    explicit GpioPulseOutput(Lines &lines, std::chrono::nanoseconds miss_tolerance = std::chrono::microseconds(20))
+        : lines_(lines), miss_tolerance_(miss_tolerance)
+    {
+    }
+
+    void writeFrame(const std::uint16_t *widths_us, std::size_t count, typename Clock::time_point start) {
+        count = std::min(count, ServoPlanner::maxChannels);
+        if(count != ordered_) {
+            for(std::size_t i = 0; i < count; i++) {
+                order_[i] = static_cast<std::uint8_t>(i);
+            }
+            ordered_ = count;
+        }
+        // insertion sort starting from last frame's order, servos move little per frame so it's nearly sorted
+        for(std::size_t i = 1; i < count; i++) {
+            std::uint8_t c = order_[i];
+            std::size_t j = i;
+            while(j > 0 && widths_us[order_[j - 1]] > widths_us[c]) {
+                order_[j] = order_[j - 1];
+                j--;
+            }
+            order_[j] = c;
+        }
+
+        const std::uint64_t all = (1ULL << count) - 1;
+        Clock::sleepUntil(start);
+        lines_.setValues(all, all);
+        writes_++;
+
+        for(std::size_t i = 0; i < count;) {
+            std::uint16_t width = widths_us[order_[i]];
+            std::uint64_t mask = 0;
+            std::size_t first = i;
+            while(i < count && widths_us[order_[i]] == width) {
+                mask |= 1ULL << order_[i];
+                i++;
+            }
+            auto deadline = start + std::chrono::microseconds(width);
+            Clock::sleepUntil(deadline);
+            lines_.setValues(mask, 0);
+            writes_++;
+
+            auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - deadline);
+            worst_lateness_ = std::max(worst_lateness_, late);
+            for(std::size_t k = first; k < i; k++) {
+                if(late > miss_tolerance_) {
+                    misses_++;
+                    EMB_PROBE2(deadline_miss, order_[k], late.count());
+                } else {
+                    EMB_PROBE2(deadline_hit, order_[k], late.count());
+                }
+            }
+        }
+    }
+
+    std::uint64_t writes() const { return writes_; }
+    std::uint64_t misses() const { return misses_; }
+    std::chrono::nanoseconds worstLateness() const { return worst_lateness_; }
+};
+
+template <typename Clock, typename Output>
+class ServoMotion {
+private:
+    ServoPlanner &planner_;
+    Output &output_;
+    typename Clock::time_point next_{};
+    bool started_ = false;
+
+public:
+    static constexpr auto frame = std::chrono::microseconds(20000);
+
+    ServoMotion(ServoPlanner &planner, Output &output) : planner_(planner), output_(output) {}
+
+    // Waits for the frame start and outputs the current widths, then plans the next frame
+    void runFrames(std::uint64_t frames) {
+        if(!started_) {
+            next_ = Clock::now();
+            started_ = true;
+        }
+        for(std::uint64_t f = 0; f < frames; f++) {
+            Clock::sleepUntil(next_);
+            output_.writeFrame(planner_.widths(), planner_.channels(), next_);
+            planner_.advance(frame);
+            next_ += frame;
+        }
+    }
+
+    // Runs until every channel has reached its target, returns the number of frames it took
+    std::uint64_t runUntilSettled(std::uint64_t max_frames = 100000) {
+        std::uint64_t frames = 0;
+        while(!planner_.settled() && frames < max_frames) {
+            runFrames(1);
+            frames++;
+        }
+        return frames;
+    }
+};
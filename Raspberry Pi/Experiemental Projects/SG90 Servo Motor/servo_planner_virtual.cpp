@@ -0,0 +1,161 @@
+/*
+    Runs ServoMotion from servo_planner.hpp with 16 channels on VirtualClock and a recording stand-in for GpioLines,
+    once with trapezoidal and once with S-curve trajectories, and checks:
+
+        - every frame starts exactly 20 ms after the previous one, with one write raising all 16 lines
+        - every channel falls exactly its planned pulse width after the rise, no more than 17 writes per frame
+        - no trajectory exceeds the speed / acceleration limits and every channel ends on its target, except
+          right after a retarget overshoots into an end stop (counted)
+
+    ./servo_planner_virtual [moves]     default 200 random moves of all channels
+*/
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "../Common/clock.hpp"
+#include "servo_planner.hpp"
+
+static constexpr std::size_t channels = 16;
+
+struct RecordingLines {
+    struct Write {
+        VirtualClock::time_point when;
+        std::uint64_t mask;
+        std::uint64_t bits;
+    };
+    std::vector<Write> writes;
+
+    void setValues(std::uint64_t mask, std::uint64_t bits) {
+        writes.push_back({VirtualClock::now(), mask, bits});
+    }
+};
+
+// Keeps the widths handed to each frame so the edges can be checked against them
+struct CheckedOutput {
+    GpioPulseOutput<VirtualClock, RecordingLines> gpio;
+    std::vector<std::array<std::uint16_t, channels>> frames;
+
+    explicit CheckedOutput(RecordingLines &lines) : gpio(lines) {}
+
+    void writeFrame(const std::uint16_t *widths, std::size_t count, VirtualClock::time_point start) {
+        std::array<std::uint16_t, channels> copy{};
+        std::copy(widths, widths + count, copy.begin());
+        frames.push_back(copy);
+        gpio.writeFrame(widths, count, start);
+    }
+};
+
+int check(MotionProfile profile, const char *name, std::uint64_t moves) {
+    VirtualClock::reset();
+    RecordingLines lines;
+    CheckedOutput output(lines);
+    ServoLimits limits;
+    ServoPlanner planner(channels, limits, profile);
+    ServoMotion<VirtualClock, CheckedOutput> motion(planner, output);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> angle(0, 180);
+    std::uint64_t errors = 0, frames = 0;
+    float maxSpeed = 0, maxAccel = 0;
+    std::uint64_t endStopFrames = 0;
+    std::array<float, channels> lastPos{}, lastVel{};
+    std::array<std::uint32_t, channels> lastEndStops{}, sinceEndStop{};
+    for(std::size_t c = 0; c < channels; c++) {
+        lastPos[c] = planner.axis(c).position();
+        sinceEndStop[c] = 100;
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    for(std::uint64_t m = 0; m < moves; m++) {
+        for(std::size_t c = 0; c < channels; c++) {
+            planner.moveTo(c, angle(rng));
+        }
+        // every fourth move retargets half-way through, the trajectories have to brake or turn around
+        std::uint64_t limit = m % 4 == 3 ? 15 : 100000;
+        while(!planner.settled() && limit-- > 0) {
+            motion.runFrames(1);
+            frames++;
+            const float dt = 0.02f;
+            for(std::size_t c = 0; c < channels; c++) {
+                float pos = planner.axis(c).position();
+                float vel = (pos - lastPos[c]) / dt;
+                maxSpeed = std::max(maxSpeed, std::abs(vel));
+                // an overshoot cut off at an end stop is allowed to break the acceleration limit, for as many
+                // frames as the S-curve average spreads it over
+                if(planner.axis(c).endStops() != lastEndStops[c]) {
+                    endStopFrames += planner.axis(c).endStops() - lastEndStops[c];
+                    lastEndStops[c] = planner.axis(c).endStops();
+                    sinceEndStop[c] = 0;
+                }
+                if(++sinceEndStop[c] > 17) {
+                    maxAccel = std::max(maxAccel, std::abs(vel - lastVel[c]) / dt);
+                }
+                lastPos[c] = pos;
+                lastVel[c] = vel;
+            }
+        }
+    }
+    frames += motion.runUntilSettled();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+
+    // walk the writes frame by frame
+    std::size_t w = 0;
+    std::uint64_t maxWrites = 0;
+    for(std::size_t f = 0; f < output.frames.size(); f++) {
+        const auto &rise = lines.writes[w];
+        auto expectedStart = VirtualClock::time_point{} + f * std::chrono::microseconds(20000);
+        if(rise.mask != 0xFFFF || rise.bits != 0xFFFF || rise.when != expectedStart) {
+            if(errors++ < 10) {
+                std::cerr << "frame " << f << ": bad rise" << std::endl;
+            }
+        }
+        std::size_t first = w++;
+        std::uint64_t fallen = 0;
+        while(w < lines.writes.size() && lines.writes[w].bits == 0) {
+            const auto &fall = lines.writes[w];
+            for(std::size_t c = 0; c < channels; c++) {
+                if(fall.mask & (1ULL << c)) {
+                    auto width = std::chrono::duration_cast<std::chrono::microseconds>(fall.when - rise.when).count();
+                    if(width != output.frames[f][c] && errors++ < 10) {
+                        std::cerr << "frame " << f << " channel " << c << ": " << width << " us, planned "
+                                  << output.frames[f][c] << std::endl;
+                    }
+                }
+            }
+            fallen |= fall.mask;
+            w++;
+        }
+        maxWrites = std::max<std::uint64_t>(maxWrites, w - first);
+        if(fallen != 0xFFFF && errors++ < 10) {
+            std::cerr << "frame " << f << ": not every line fell" << std::endl;
+        }
+    }
+    for(std::size_t c = 0; c < channels; c++) {
+        if(planner.axis(c).position() != planner.axis(c).target()) {
+            errors++;
+        }
+    }
+    bool limitsOk = maxSpeed <= limits.max_speed * 1.001f && maxAccel <= limits.max_accel * 1.001f + 1;
+
+    double simulated = std::chrono::duration<double>(VirtualClock::now().time_since_epoch()).count();
+    std::cout << name << ": " << moves << " moves, " << frames << " frames (" << simulated << " s simulated in "
+              << wall.count() * 1000 << " ms), " << lines.writes.size() << " writes, at most " << maxWrites
+              << " per frame (" << 2 * channels << " with one rise and fall per servo)" << std::endl;
+    std::cout << "  peak speed " << maxSpeed << " deg/s (limit " << limits.max_speed << "), peak accel " << maxAccel
+              << " deg/s^2 (limit " << limits.max_accel << "), " << endStopFrames << " end stop frames, late deadlines " << VirtualClock::lateDeadlines()
+              << ", errors " << errors << std::endl;
+    return errors == 0 && maxWrites <= channels + 1 && limitsOk && VirtualClock::lateDeadlines() == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    std::uint64_t moves = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+    int failed = check(MotionProfile::Trapezoidal, "trapezoidal", moves);
+    failed |= check(MotionProfile::SCurve, "S-curve", moves);
+    return failed;
+}
@@ -0,0 +1,53 @@
+/*
+    The SG90 sweep from servo_motor_control_SG90.cpp as a template over the clock and the output line,
+    so it can run on hardware (SteadyClock + gpiod::line) or in a test (VirtualClock + a recording line).
+
+    One step is a pulse of 500, 1500 or 2500 us (0, 90 and 180 degrees) followed by a 500 us gap,
+    the position changes every 700 steps and the pattern repeats after 2100 steps.
+    Deadlines are absolute, so a late wake-up shortens the next gap instead of shifting every later pulse.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+template <typename Clock, typename Line>
+class ServoSweep {
+private:
+    Line &pwm_;
+
+public:
+    static constexpr std::uint64_t stepsPerCycle = 2100;
+    static constexpr auto gap = std::chrono::microseconds(500);
+
+    explicit ServoSweep(Line &pwm) : pwm_(pwm) {}
+
+    static std::chrono::microseconds pulseWidth(std::uint64_t step) {
+        std::uint64_t count = step % stepsPerCycle + 1;
+        if(count < 700) {
+            return std::chrono::microseconds(500);
+        } else if(count < 1400) {
+            return std::chrono::microseconds(1500);
+        }
+        return std::chrono::microseconds(2500);
+    }
+
+    void run(std::uint64_t steps) {
+        auto next = Clock::now();
+        for(std::uint64_t step = 0; step < steps; step++) {
+            pwm_.set_value(1);
+            next += pulseWidth(step);
+            Clock::sleepUntil(next);
+            pwm_.set_value(0);
+            next += gap;
+            Clock::sleepUntil(next);
+        }
+    }
+
+    void runForever() {
+        while(true) {
+            run(stepsPerCycle);
+        }
+    }
+};
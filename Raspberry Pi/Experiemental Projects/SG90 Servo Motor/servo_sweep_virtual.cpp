@@ -0,0 +1,61 @@
+/*
+    Runs the SG90 sweep from servo_sweep.hpp on VirtualClock with a line that records every edge,
+    then checks each pulse and gap against the expected schedule.
+
+    ./servo_sweep_virtual [cycles]     default 1000 cycles of 2100 steps (about 70 minutes of servo time)
+*/
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "../Common/clock.hpp"
+#include "servo_sweep.hpp"
+
+struct RecordingLine {
+    struct Edge {
+        VirtualClock::time_point when;
+        int value;
+    };
+    std::vector<Edge> edges;
+
+    void set_value(int value) {
+        edges.push_back({VirtualClock::now(), value});
+    }
+};
+
+int main(int argc, char **argv) {
+    std::uint64_t cycles = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+    std::uint64_t steps = cycles * ServoSweep<VirtualClock, RecordingLine>::stepsPerCycle;
+
+    RecordingLine line;
+    line.edges.reserve(steps * 2);
+    ServoSweep<VirtualClock, RecordingLine> sweep(line);
+
+    VirtualClock::reset();
+    auto wallStart = std::chrono::steady_clock::now();
+    sweep.run(steps);
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+
+    std::uint64_t errors = 0;
+    for(std::uint64_t step = 0; step < steps; step++) {
+        const auto &rise = line.edges[2 * step];
+        const auto &fall = line.edges[2 * step + 1];
+        auto width = fall.when - rise.when;
+        auto expected = ServoSweep<VirtualClock, RecordingLine>::pulseWidth(step);
+        bool gapOk = step + 1 == steps || line.edges[2 * step + 2].when - fall.when == std::chrono::microseconds(500);
+        if(rise.value != 1 || fall.value != 0 || width != expected || !gapOk) {
+            if(errors++ < 10) {
+                std::cerr << "step " << step << ": pulse " << std::chrono::duration_cast<std::chrono::microseconds>(width).count()
+                          << " us, expected " << expected.count() << " us" << std::endl;
+            }
+        }
+    }
+
+    double simulated = std::chrono::duration<double>(VirtualClock::now().time_since_epoch()).count();
+    std::cout << steps << " steps, " << line.edges.size() << " edges, " << simulated << " s simulated in "
+              << wall.count() * 1000.0 << " ms (" << simulated / wall.count() << "x)" << std::endl;
+    std::cout << "late deadlines: " << VirtualClock::lateDeadlines() << ", pulse errors: " << errors << std::endl;
+    return errors == 0 && VirtualClock::lateDeadlines() == 0 ? 0 : 1;
+}
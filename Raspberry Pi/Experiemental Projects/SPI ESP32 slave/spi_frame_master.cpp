@@ -0,0 +1,81 @@
+/*
+    Framed SPI master: streams batched 12-bit samples and an LED command to the ESP32 slave
+    (ESP32/SPI/spi_slave_frames.cpp) in CRC-checked frames (Shared/spi_frame.hpp).
+
+    ./spi_frame_master [clock Hz] [sample rate] [samples per frame]     default 8 MHz, 100000 samples/s, 256
+
+    Every 10 ms the samples of that period (a sawtooth, standing in for a real source) go out as frames of
+    samples per frame, packed into transactions of up to 4096 bytes; once a second a command frame (opcode 1)
+    switches the slave's LED. Compare the numbers printed here with what the slave reports.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstdint>
+
+#include "../Common/spi_device.hpp"
+#include "../Common/spi_frame_sender.hpp"
+
+const char* spiDevice = "/dev/spidev0.0";
+const std::size_t transactionBytes = 4096;      // slave buffer size
+const std::uint8_t cmdLed = 1;
+
+int main(int argc, char *argv[]) {
+    std::uint32_t speed = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 8000000;
+    std::uint32_t sampleRate = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 100000;
+    std::size_t perFrame = argc > 3 ? std::strtoul(argv[3], nullptr, 0) : 256;
+    if(speed == 0 || sampleRate < 100 || perFrame == 0) {
+        std::cerr << "usage: " << argv[0] << " [clock Hz] [sample rate, at least 100] [samples per frame, at least 1]"
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        SpiDevice spi(spiDevice, SPI_MODE_0, 8, speed);
+        SpiFrameSender<SpiDevice> sender(spi, transactionBytes, perFrame);
+
+        const auto period = std::chrono::milliseconds(10);
+        std::vector<std::uint16_t> samples(sampleRate / 100);
+        std::uint32_t phase = 0;
+        bool led = false;
+
+        auto next = std::chrono::steady_clock::now();
+        auto lastPrint = next;
+        std::uint64_t lastBytes = 0;
+        int periods = 0;
+
+        while(true) {
+            for(auto &s : samples) {
+                s = static_cast<std::uint16_t>(phase++ & 0x0FFF);
+            }
+            sender.addSamples(samples.data(), samples.size());
+            if(++periods % 100 == 0) {
+                led = !led;
+                sender.addCommand(cmdLed, led);
+            }
+            sender.flush();
+
+            auto now = std::chrono::steady_clock::now();
+            if(now - lastPrint >= std::chrono::seconds(1)) {
+                double dt = std::chrono::duration<double>(now - lastPrint).count();
+                double bits = (sender.bytes() - lastBytes) * 8 / dt;
+                std::cout << std::fixed << std::setprecision(2) << sender.frames() << " frames in "
+                          << sender.transactions() << " transactions, " << bits / 1e6 << " Mbit/s = "
+                          << std::setprecision(1) << 100.0 * bits / speed << "% of " << speed / 1e6 << " MHz" << std::endl;
+                lastPrint = now;
+                lastBytes = sender.bytes();
+            }
+
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    } catch(const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
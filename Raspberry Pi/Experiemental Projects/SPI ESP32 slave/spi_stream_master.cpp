@@ -0,0 +1,76 @@
+/*
+    SPI master streaming frames to the ESP32 DMA slave (ESP32/SPI/spi_slave_dma_stream.c) as fast as spidev allows.
+
+    ./spi_stream_master [clock Hz] [frame bytes] [seconds]     default 8 MHz, 4096 bytes, run forever
+
+    Each frame is one transfer with chip select held for the whole frame, the first four bytes are a little-endian
+    frame counter so the slave can count what it missed. Frame bytes must be a multiple of 4 (slave DMA) and fit
+    spidev's bufsiz (4096 unless the module was loaded with a larger spidev.bufsiz).
+
+    Prints once a second what the master achieved: frames/s, Mbit/s and the share of the clock rate, the gap
+    between frames being the ioctl round trip. The slave prints the same numbers from its side.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+
+#include "../Common/spi_device.hpp"
+
+const char* spiDevice = "/dev/spidev0.0";
+
+int main(int argc, char *argv[]) {
+    std::uint32_t speed = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 8000000;
+    std::size_t frameBytes = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 4096;
+    long seconds = argc > 3 ? std::atol(argv[3]) : 0;
+    if(speed == 0 || frameBytes < 4 || frameBytes % 4 != 0) {
+        std::cerr << "usage: " << argv[0] << " [clock Hz] [frame bytes, a multiple of 4] [seconds]" << std::endl;
+        return 1;
+    }
+
+    try {
+        SpiDevice spi(spiDevice, SPI_MODE_0, 8, speed);
+
+        std::vector<std::uint8_t> frame(frameBytes);
+        for(std::size_t i = 4; i < frameBytes; i++) {
+            frame[i] = static_cast<std::uint8_t>(i);
+        }
+
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        auto lastPrint = start;
+        std::uint32_t counter = 0;
+        std::uint32_t printedCounter = 0;
+
+        while(true) {
+            frame[0] = static_cast<std::uint8_t>(counter);
+            frame[1] = static_cast<std::uint8_t>(counter >> 8);
+            frame[2] = static_cast<std::uint8_t>(counter >> 16);
+            frame[3] = static_cast<std::uint8_t>(counter >> 24);
+            spi.transfer(frame.data(), nullptr, frame.size());
+            counter++;
+
+            auto now = clock::now();
+            if(now - lastPrint >= std::chrono::seconds(1)) {
+                double dt = std::chrono::duration<double>(now - lastPrint).count();
+                double fps = (counter - printedCounter) / dt;
+                double bits = fps * frameBytes * 8;
+                std::cout << std::fixed << std::setprecision(1) << fps << " frames/s, " << std::setprecision(2)
+                          << bits / 1e6 << " Mbit/s = " << std::setprecision(1) << 100.0 * bits / speed
+                          << "% of " << speed / 1e6 << " MHz, " << counter << " frames sent" << std::endl;
+                lastPrint = now;
+                printedCounter = counter;
+                if(seconds > 0 && now - start >= std::chrono::seconds(seconds)) {
+                    break;
+                }
+            }
+        }
+    } catch(const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
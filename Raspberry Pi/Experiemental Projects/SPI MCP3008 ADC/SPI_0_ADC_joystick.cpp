@@ -1,18 +1,36 @@
+/*
+    Joystick on MCP3008 channels 0 (X), 1 (Y) and 2 (button), LEDs on GPIO 17, 27 and 22.
+
+    The stick is scanned at 1 kHz (all three channels in one SPI message) but the LEDs only react to joystick
+    events: pushing X right runs the yellow -> green -> red chase, left runs it the other way, back to the centre
+    switches them off. The chase is stepped from the scan loop instead of sleeping, so scanning never pauses.
+
+    ./SPI_0_ADC_joystick          hardware, keep the stick released for the first 200 ms (centre calibration)
+    ./SPI_0_ADC_joystick --sim    no hardware: a noisy synthetic stick through the same Joystick code
+    --rt                          real-time profile (see Common/rt_profile.hpp)
+
+    Every 5 s it prints scans vs events, the worst scan-to-event delay and the scan loop's deadline monitor
+    (Shared/deadline_monitor.hpp), kill -USR1 <pid> prints the monitor at any time.
+*/
+
 #include <iostream>
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <linux/spi/spidev.h>
-#include <cstring>
+#include <string>
 #include <chrono>
 #include <thread>
+#include <random>
+#include <cmath>
+#include <algorithm>
 #include <gpiod.hpp>
 
+#include "../Common/spi_device.hpp"
+#include "../Common/mcp3008.hpp"
+#include "../Common/joystick.hpp"
+#include "../Common/rt_profile.hpp"
+#include "../../../Shared/deadline_monitor.hpp"
+
 // spi setup
 const char* spiDevice = "/dev/spidev0.0";
-uint8_t mode = SPI_MODE_0;
-uint8_t bits = 8;  // Changed to 8 bits
-uint32_t speed = 1000000;  // 1 MHz, adjust as needed
+const uint32_t speed = 1000000;  // 1 MHz, three conversions take ~80 us
 
 // gpio pins setup
 const char* gpiopathname = "/dev/gpiochip0";
@@ -21,130 +39,170 @@ const uint8_t offset_green = 27;
 const uint8_t offset_red = 22;
 const auto consumer = std::string("led run");
 
-gpiod::chip chip(gpiopathname);
+const std::uint8_t scanChannels[3] = {0, 1, 2};
+const auto scanPeriod = std::chrono::milliseconds(1);
+const auto chaseStep = std::chrono::milliseconds(500);
 
-gpiod::line line_yellow = chip.get_line(offset_yellow);
-gpiod::line line_green = chip.get_line(offset_green);
-gpiod::line line_red = chip.get_line(offset_red);
-
-
-int spi_fd;
-
-bool spi_init() {
-    spi_fd = open(spiDevice, O_RDWR);
-    if (spi_fd < 0) {
-        std::cerr << "Error opening SPI device" << std::endl;
-        return false;
-    }
+std::uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-    if (ioctl(spi_fd, SPI_IOC_WR_MODE, &mode) < 0) {
-        std::cerr << "Error setting SPI mode" << std::endl;
-        return false;
+// yellow -> green -> red (forward) or red -> green -> yellow, one LED at a time while the stick is held
+class LedChase {
+private:
+    gpiod::line *leds_[3];
+    int direction_ = 0;
+    int step_ = 0;
+    std::chrono::steady_clock::time_point next_;
+
+    void show(int lit) {
+        for(int i = 0; i < 3; i++) {
+            leds_[i]->set_value(i == lit);
+        }
     }
 
-    if (ioctl(spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) {
-        std::cerr << "Error setting bits per word" << std::endl;
-        return false;
+public:
+    LedChase(gpiod::line &yellow, gpiod::line &green, gpiod::line &red) : leds_{&yellow, &green, &red} {}
+
+    void setDirection(int direction) {
+        if(direction == direction_) {
+            return;
+        }
+        direction_ = direction;
+        step_ = 0;
+        next_ = std::chrono::steady_clock::now();
+        if(direction_ == 0) {
+            show(-1);
+        }
     }
 
-    if (ioctl(spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
-        std::cerr << "Error setting max speed" << std::endl;
-        return false;
+    void poll(std::chrono::steady_clock::time_point now) {
+        if(direction_ == 0 || now < next_) {
+            return;
+        }
+        show(direction_ > 0 ? step_ : 2 - step_);
+        step_ = (step_ + 1) % 3;
+        next_ += chaseStep;
     }
+};
 
-    return true;
+void printEvent(const JoystickEvent &ev) {
+    std::cout << "x " << int(ev.state.x) << " y " << int(ev.state.y) << (ev.state.pressed ? " pressed" : "")
+              << "  (" << ev.delay_ns / 1000 << " us after the first scan)" << std::endl;
 }
 
-void spi_close() {
-    if (spi_fd >= 0) {
-        close(spi_fd);
-    }
+void printStats(const Joystick &stick) {
+    std::cout << stick.samples() << " scans, " << stick.events() << " events ("
+              << (stick.samples() ? 100.0 * stick.events() / stick.samples() : 0.0) << " %), delay mean "
+              << stick.meanDelayNs() / 1000 << " us, max " << stick.maxDelayNs() / 1000 << " us + up to "
+              << std::chrono::duration_cast<std::chrono::microseconds>(scanPeriod).count() << " us scan period"
+              << std::endl;
 }
 
-uint16_t readADC() {
-    uint8_t tx[3] = {0x01, 0x80, 0x00};  // Start bit, Single-ended, Channel 0
-    uint8_t rx[3] = {0};
-
-    struct spi_ioc_transfer tr = {
-        .tx_buf = (unsigned long)tx,
-        .rx_buf = (unsigned long)rx,
-        .len = 3,
-        .speed_hz = speed,
-        .delay_usecs = 0,
-        .bits_per_word = bits,
-    };
-
-    if (ioctl(spi_fd, SPI_IOC_MESSAGE(1), &tr) < 0) {
-        std::cerr << "Error sending SPI message" << std::endl;
-        return 0;
-    }
+// Synthetic stick: slow sweeps on X, a couple of button presses, +-6 counts of noise, scanned every 1 ms
+int simulate() {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> noise(-6, 6);
+    Joystick stick;
 
-    // Combine the two data bytes into a 10-bit result
-    return ((rx[1] & 0x03) << 8) | rx[2];
-}
-
-// gpio pin reset for led pins
-void setLEDsToZero() {
-    line_yellow.set_value(0);
-    line_green.set_value(0);
-    line_red.set_value(0);
+    JoystickSample rest[200];
+    for(auto &s : rest) {
+        s = {static_cast<std::uint16_t>(507 + noise(rng)), static_cast<std::uint16_t>(518 + noise(rng)), 1023, 0};
+    }
+    stick.calibrate(rest, 200);
+    std::cout << "centre " << stick.config().centre_x << ", " << stick.config().centre_y << std::endl;
+
+    JoystickEvent ev;
+    const std::uint64_t scans = 60000;
+    for(std::uint64_t i = 0; i < scans; i++) {
+        double t = i / 1000.0;
+        int x = 507 + static_cast<int>(515 * std::sin(t * 0.7)) + noise(rng);
+        int y = 518 + noise(rng);
+        int button = (i % 10000) < 300 ? 20 + noise(rng) : 1015 + noise(rng);
+        JoystickSample s = {static_cast<std::uint16_t>(std::clamp(x, 0, 1023)), static_cast<std::uint16_t>(y),
+                            static_cast<std::uint16_t>(std::clamp(button, 0, 1023)), 1000000000ULL + i * 1000000ULL};
+        if(stick.update(s, ev)) {
+            printEvent(ev);
+        }
+    }
+    printStats(stick);
+    return 0;
 }
 
-int main() {
-    if (!spi_init()) {
-        return -1;
+int main(int argc, char **argv) {
+    for(int i = 1; i < argc; i++) {
+        if(std::string(argv[i]) == "--sim") {
+            return simulate();
+        }
     }
 
-    // gpio pins direction setup
-    line_yellow.request({consumer,gpiod::line_request::DIRECTION_OUTPUT},0);
-    line_green.request({consumer,gpiod::line_request::DIRECTION_OUTPUT},0);
-    line_red.request({consumer,gpiod::line_request::DIRECTION_OUTPUT},0);
-
-    while(1) {
-        uint16_t adcValue = readADC();
-        float voltage = (adcValue / 1023.0) * 3.3;  // Assuming 3.3V reference
-        std::cout << "ADC Value: " << adcValue << ", Voltage: " << voltage << "V" << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Read every second
-	    
-	try {
-	    if(voltage > 2) {
-            line_yellow.set_value(1);
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setLEDsToZero();
-
-            line_green.set_value(1);
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setLEDsToZero();
-            
-            line_red.set_value(1);
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setLEDsToZero();
-
-	    } else if(voltage < 1) {
-            line_red.set_value(1);
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setLEDsToZero();
-
-            line_green.set_value(1);
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setLEDsToZero();
-            
-            line_yellow.set_value(1);
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setLEDsToZero();
-
-	    } else {
-		    setLEDsToZero();
-	    }   
-	}
-	catch(const std::exception& e) {
-	    std::cerr << e.what();
-	}	
-
+    try {
+        if(rtRequested(argc, argv)) {
+            applyRtProfile();
+        }
+
+        SpiDevice spi(spiDevice, SPI_MODE_0, 8, speed);
+        Mcp3008 adc(spi);
+
+        gpiod::chip chip(gpiopathname);
+        gpiod::line line_yellow = chip.get_line(offset_yellow);
+        gpiod::line line_green = chip.get_line(offset_green);
+        gpiod::line line_red = chip.get_line(offset_red);
+        line_yellow.request({consumer,gpiod::line_request::DIRECTION_OUTPUT},0);
+        line_green.request({consumer,gpiod::line_request::DIRECTION_OUTPUT},0);
+        line_red.request({consumer,gpiod::line_request::DIRECTION_OUTPUT},0);
+        LedChase chase(line_yellow, line_green, line_red);
+
+        std::uint16_t raw[3];
+        auto scan = [&]() {
+            JoystickSample s;
+            s.time_ns = nowNs();
+            adc.readChannels(scanChannels, raw, 3);
+            s.x = raw[0];
+            s.y = raw[1];
+            s.button = raw[2];
+            return s;
+        };
+
+        Joystick stick;
+        JoystickSample rest[200];
+        for(auto &s : rest) {
+            s = scan();
+            std::this_thread::sleep_for(scanPeriod);
+        }
+        stick.calibrate(rest, 200);
+        std::cout << "centre " << stick.config().centre_x << ", " << stick.config().centre_y << std::endl;
+
+        DeadlineMonitor::enableReportTrigger();
+        DeadlineMonitor monitor("joystick scan",
+                                std::chrono::duration_cast<std::chrono::microseconds>(scanPeriod).count(),
+                                DeadlineSchedule::Absolute);
+
+        JoystickEvent ev;
+        auto next = std::chrono::steady_clock::now();
+        auto nextStats = next + std::chrono::seconds(5);
+        while(true) {
+            monitor.start();
+            if(stick.update(scan(), ev)) {
+                printEvent(ev);
+                chase.setDirection(ev.state.x > 0 ? 1 : ev.state.x < 0 ? -1 : 0);
+            }
+            auto now = std::chrono::steady_clock::now();
+            chase.poll(now);
+            if(now >= nextStats) {
+                printStats(stick);
+                DeadlineMonitor::report();
+                nextStats += std::chrono::seconds(5);
+            }
+            monitor.finish();
+            DeadlineMonitor::reportIfRequested();
+            next += scanPeriod;
+            std::this_thread::sleep_until(next);
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
-    spi_close();
-    
     return 0;
 }
-
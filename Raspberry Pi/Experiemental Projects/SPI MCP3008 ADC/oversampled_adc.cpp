@@ -0,0 +1,107 @@
+/*
+    MCP3008 channel read with oversampling (Shared/oversample.hpp), 10 bits + n extra.
+
+    ./oversampled_adc [channel] [extra bits]    hardware, default channel 0 and 3 extra bits (13-bit results)
+    ./oversampled_adc --bench [extra bits]      no hardware: a dithered 511.3 LSB input to show the extra bits
+                                                are real, and the decimation throughput in samples/s
+
+    Conversions are read 8 per SPI message (Mcp3008::readChannels with the same channel repeated).
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "../Common/spi_device.hpp"
+#include "../Common/mcp3008.hpp"
+#include "../../../Shared/oversample.hpp"
+
+const char* spiDevice = "/dev/spidev0.0";
+const uint32_t speed = 1350000;     // MCP3008 maximum at 3.3 V
+const std::size_t perMessage = 8;
+
+int bench(unsigned extra_bits) {
+    Oversampler os(extra_bits);
+
+    // true value 511.3 LSB with uniform noise of +-1 LSB before the 10-bit quantiser
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> noise(-1.0, 1.0);
+    const double truth = 511.3;
+    std::vector<std::uint16_t> samples(1 << 20);
+    for(auto &s : samples) {
+        s = static_cast<std::uint16_t>(truth + noise(rng) + 0.5);
+    }
+
+    std::vector<std::uint32_t> out(samples.size() / os.groupSize() + 1);
+    std::size_t n = os.process(samples.data(), samples.size(), out.data());
+    double mean = 0, worst = 0;
+    for(std::size_t i = 0; i < n; i++) {
+        double lsb = out[i] / double(1 << extra_bits);
+        mean += lsb;
+        worst = std::max(worst, std::abs(lsb - truth));
+    }
+    mean /= n;
+    std::cout << std::fixed << std::setprecision(3) << "input " << truth << " LSB, " << 10 + extra_bits
+              << "-bit outputs: mean " << mean << ", worst error " << worst << " LSB (10-bit step is 1.000, "
+              << 10 + extra_bits << "-bit step " << 1.0 / (1 << extra_bits) << ")" << std::endl;
+
+    // throughput on blocks the size of an ESP32 continuous-mode frame
+    const std::size_t block = 256;
+    const int rounds = 200;
+    auto t0 = std::chrono::steady_clock::now();
+    std::size_t outputs = 0;
+    for(int r = 0; r < rounds; r++) {
+        for(std::size_t i = 0; i < samples.size(); i += block) {
+            outputs += os.process(samples.data() + i, block, out.data());
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << std::setprecision(1) << rounds * samples.size() / seconds / 1e6 << " M samples/s decimated ("
+              << outputs << " outputs)" << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1 && std::string(argv[1]) == "--bench") {
+        return bench(argc > 2 ? std::atoi(argv[2]) : 3);
+    }
+
+    try {
+        std::uint8_t channel = argc > 1 ? static_cast<std::uint8_t>(std::atoi(argv[1])) : 0;
+        unsigned extra_bits = argc > 2 ? std::atoi(argv[2]) : 3;
+
+        SpiDevice spi(spiDevice, SPI_MODE_0, 8, speed);
+        Mcp3008 adc(spi);
+        Oversampler os(extra_bits);
+        const std::uint32_t fullScale = os.fullScale(10);
+
+        std::uint8_t channels[perMessage];
+        for(auto &c : channels) {
+            c = channel;
+        }
+        std::uint16_t raw[perMessage];
+        std::uint32_t out[perMessage];
+        auto nextPrint = std::chrono::steady_clock::now();
+        while(true) {
+            adc.readChannels(channels, raw, perMessage);
+            std::size_t n = os.process(raw, perMessage, out);
+            // tens of thousands of conversions per second, print the latest result 5 times a second
+            if(n > 0 && std::chrono::steady_clock::now() >= nextPrint) {
+                nextPrint = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+                std::size_t i = n - 1;
+                std::cout << "raw " << raw[perMessage - 1] << " / 1023, oversampled " << out[i] << " / " << fullScale
+                          << ", voltage " << std::setprecision(5) << out[i] * 3.3 / fullScale << " V" << std::endl;
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+    Vibration spectrum from one MCP3008 channel (Shared/spectrum.hpp), 1024-point frames with 50 % overlap.
+
+    ./vibration_spectrum [channel]     hardware: reads the channel as fast as the SPI bus allows (8 conversions per
+                                       SPI message), prints the strongest peaks and the CPU share of the FFT stage
+                                       once a second; 1.35 MHz clock, the MCP3008 maximum at 2.7 V and safe on the
+                                       Pi's 3.3 V rail
+    ./vibration_spectrum [channel] --5v
+                                       the same at 3.6 MHz, only for an MCP3008 powered from 5 V (with the level
+                                       shifting that needs), above its rating at 3.3 V
+    ./vibration_spectrum --bench       no hardware: two tones in noise at 200 kS/s (the MCP3008 maximum at 5 V)
+                                       to check the peaks and how much faster than real time the stage runs
+
+    Reading and FFT run on the same thread, so "FFT load" below 100 % means one core keeps up with the ADC.
+    The sample rate is measured from the conversions per second actually achieved, spidev leaves small gaps
+    between messages so treat frequencies as +-1 % on hardware.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+
+#include "../Common/spi_device.hpp"
+#include "../Common/mcp3008.hpp"
+#include "../Common/rt_profile.hpp"
+#include "../../../Shared/spectrum.hpp"
+
+const char* spiDevice = "/dev/spidev0.0";
+const uint32_t speed = 1350000;     // MCP3008 maximum at 2.7 V, so always within spec at 3.3 V
+const uint32_t speed5V = 3600000;   // MCP3008 maximum at 5 V, --5v
+const std::size_t fftSize = 1024;
+const std::size_t perMessage = 8;
+
+void printPeaks(const Spectrum &spectrum) {
+    for(std::size_t i = 0; i < spectrum.peakCount() && i < 3; i++) {
+        const SpectrumPeak &p = spectrum.peaks()[i];
+        std::cout << "  " << std::fixed << std::setprecision(1) << std::setw(8) << p.frequency_hz << " Hz  "
+                  << std::setprecision(2) << p.amplitude;
+    }
+    std::cout << std::endl;
+}
+
+int bench() {
+    const float rate = 200000;
+    const std::size_t total = static_cast<std::size_t>(rate) * 20;
+    Spectrum spectrum(fftSize, fftSize / 2, rate, SpectrumWindow::Hann, 8, 2.0f);
+
+    // 10-bit codes: 512 offset, 1234.5 Hz at 200 counts, 31 kHz at 40 counts, +-4 counts of noise
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> noise(-4, 4);
+    std::vector<std::uint16_t> samples(total);
+    for(std::size_t i = 0; i < total; i++) {
+        double t = i / static_cast<double>(rate);
+        double v = 512 + 200 * std::sin(2 * M_PI * 1234.5 * t) + 40 * std::sin(2 * M_PI * 31000 * t) + noise(rng);
+        samples[i] = static_cast<std::uint16_t>(std::lround(std::min(1023.0, std::max(0.0, v))));
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < total; i += perMessage) {
+        spectrum.push(samples.data() + i, perMessage);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "peaks (expect 1234.5 Hz / 200 and 31000 Hz / 40):";
+    printPeaks(spectrum);
+    std::cout << spectrum.frames() << " frames of " << fftSize << " in " << std::setprecision(1) << seconds * 1000
+              << " ms, " << std::setprecision(1) << total / seconds / 1e6 << " M samples/s = "
+              << total / rate / seconds << "x real time at " << rate / 1000 << " kS/s" << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1 && std::string(argv[1]) == "--bench") {
+        return bench();
+    }
+
+    try {
+        if(rtRequested(argc, argv)) {
+            applyRtProfile();
+        }
+        std::uint8_t channel = argc > 1 && argv[1][0] != '-' ? static_cast<std::uint8_t>(std::atoi(argv[1])) : 0;
+        std::uint32_t clock = speed;
+        for(int i = 1; i < argc; i++) {
+            if(std::string(argv[i]) == "--5v") {
+                clock = speed5V;
+            }
+        }
+
+        SpiDevice spi(spiDevice, SPI_MODE_0, 8, clock);
+        Mcp3008 adc(spi);
+        // placeholder rate until the first second has been measured
+        Spectrum spectrum(fftSize, fftSize / 2, 50000, SpectrumWindow::Hann, 8, 2.0f);
+
+        std::uint8_t channels[perMessage];
+        for(auto &c : channels) {
+            c = channel;
+        }
+        std::uint16_t raw[perMessage];
+
+        auto second = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds fftTime{0};
+        std::size_t converted = 0;
+        while(true) {
+            adc.readChannels(channels, raw, perMessage);
+            auto t0 = std::chrono::steady_clock::now();
+            spectrum.push(raw, perMessage);
+            auto t1 = std::chrono::steady_clock::now();
+            fftTime += t1 - t0;
+            converted += perMessage;
+
+            if(t1 - second >= std::chrono::seconds(1)) {
+                double elapsed = std::chrono::duration<double>(t1 - second).count();
+                spectrum.setSampleRate(static_cast<float>(converted / elapsed));
+                std::cout << std::fixed << std::setprecision(0) << spectrum.sampleRate() << " S/s, FFT load "
+                          << std::setprecision(1) << 100.0 * std::chrono::duration<double>(fftTime).count() / elapsed
+                          << " %, peaks:";
+                printPeaks(spectrum);
+                second = t1;
+                fftTime = std::chrono::nanoseconds(0);
+                converted = 0;
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,100 +1,105 @@
 /*
     MCP41010 is digital potentiometer, it uses SPI interface for communication with microcontroller or SBC.
     Watch the video which is in the same folder.
+
+    ./SPI_0_digital_POT_MCP41010                 LED ramping up and down in equal steps of perceived brightness
+    ./SPI_0_digital_POT_MCP41010 --linear        the original ramp, wiper 0 -> 210 -> 0 in steps of 7
+    ./SPI_0_digital_POT_MCP41010 ldr [channel]   brightness following an LDR on an MCP3008 (/dev/spidev0.1,
+                                                 default channel 0): the darker, the brighter the LED
+
+    The brightness goes through the gamma table of Shared/brightness.hpp, the same controller the ESP32 drives its
+    LEDC fades with (ESP32/C++/LDR_led_brightness.cpp).
 */
 
 #include <iostream>
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <linux/spi/spidev.h>
-#include <cstring>
+#include <string>
 #include <chrono>
 #include <thread>
+#include <cstdlib>
 
-const char* spiDevice = "/dev/spidev0.0";
-uint8_t mode = SPI_MODE_0;
-uint8_t bits = 8;
-uint32_t speed = 1000000; 
-
-std::uint8_t spi_fd;
-
-bool spi_init() {
-    spi_fd = open(spiDevice, O_RDWR);
-    if (spi_fd < 0) {
-        std::cerr << "Error opening SPI device" << std::endl;
-        return false;
-    }
-
-    if (ioctl(spi_fd, SPI_IOC_WR_MODE, &mode) < 0) {
-        std::cerr << "Error setting SPI mode" << std::endl;
-        return false;
-    }
-
-    if (ioctl(spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) {
-        std::cerr << "Error setting bits per word" << std::endl;
-        return false;
-    }
-
-    if (ioctl(spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
-        std::cerr << "Error setting max speed" << std::endl;
-        return false;
-    }
+#include "../Common/spi_device.hpp"
+#include "../Common/mcp41010.hpp"
+#include "../Common/mcp3008.hpp"
+#include "../../../Shared/brightness.hpp"
 
-    return true;
-}
+const char* spiDevice = "/dev/spidev0.0";
+const char* adcDevice = "/dev/spidev0.1";
 
-void spi_close() {
-    if (spi_fd >= 0) {
-        close(spi_fd);
-    }
-}
+// MCP3008 readings of the LDR divider for a fully dark and a fully lit room
+const std::uint32_t darkReading = 200;
+const std::uint32_t litReading = 800;
 
-void setWiper(uint8_t value) {
-    uint8_t tx[2] = {0x00, value};  // Command byte 0x00 for write to wiper
-    uint8_t rx[2] = {0};
-
-    struct spi_ioc_transfer tr = {
-        .tx_buf = (unsigned long)tx,
-        .rx_buf = (unsigned long)rx,
-        .len = 2,
-        .speed_hz = speed,
-        .delay_usecs = 0,
-        .bits_per_word = bits,
-    };
-
-    if (ioctl(spi_fd, SPI_IOC_MESSAGE(1), &tr) < 0) {
-        std::cerr << "Error sending SPI message" << std::endl;
+int main(int argc, char *argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "gamma";
+    if(mode != "gamma" && mode != "--linear" && mode != "ldr") {
+        std::cerr << "usage: " << argv[0] << " [--linear | ldr [channel]]" << std::endl;
+        return 1;
     }
-}
 
-int main() {
-    if (!spi_init()) {
-        return -1;
-    }
+    try {
+        SpiDevice spi(spiDevice);
+        Mcp41010 pot(spi);
+
+        // Intial value of potentiometer
+        pot.setWiper(0);
+
+        if(mode == "--linear") {
+            // continously increase and decrease the LED brightness
+            while(1) {
+                for (int i = 0; i <= 210; i += 7) {
+                    pot.setWiper(static_cast<std::uint8_t>(i));
+                    std::cout << "Wiper set to: " << i << std::endl;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                }
+
+                for (int k = 210; k > 0; k -= 7) {
+                    pot.setWiper(static_cast<std::uint8_t>(k));
+                    std::cout << "Wiper set to: " << k << std::endl;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                }
+            }
+        }
 
-    // Intial value of potentiometer
-    setWiper(0);
-   
-    // continously increase and decrease the LED brightness
-    while(1) {
-        for (std::uint8_t i = 0; i <= 210; i += 7) { 
-            setWiper(i);
-            std::cout << "Wiper set to: " << static_cast<int>(i) << std::endl;
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if(mode == "ldr") {
+            std::uint8_t channel = static_cast<std::uint8_t>(argc > 2 ? std::atoi(argv[2]) : 0);
+            SpiDevice adcSpi(adcDevice);
+            Mcp3008 adc(adcSpi);
+            BrightnessController<Mcp41010> brightness(pot, darkReading, litReading, 0);
+
+            auto lastPrint = std::chrono::steady_clock::now();
+            while(1) {
+                std::uint16_t reading = adc.readChannel(channel);
+                brightness.update(reading);
+
+                auto now = std::chrono::steady_clock::now();
+                if(now - lastPrint >= std::chrono::seconds(1)) {
+                    lastPrint = now;
+                    std::cout << "LDR " << reading << ", level " << static_cast<int>(brightness.level())
+                              << ", wiper " << static_cast<int>(pot.wiper()) << ", " << brightness.changes()
+                              << " changes in " << brightness.updates() << " updates" << std::endl;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
         }
 
-        for (std::uint8_t k = 210; k > 0; k -= 7) {
-            setWiper(i);
-            std::cout << "Wiper set to: " << static_cast<int>(k) << std::endl;
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        // 0 -> 255 -> 0 in perceived brightness, the wiper moves slowly at the dark end and fast at the bright end
+        BrightnessController<Mcp41010> brightness(pot, 255, 0, 0, 2.2f, 1);
+        while(1) {
+            for (int level = 0; level <= 255; level += 5) {
+                brightness.setLevel(static_cast<std::uint8_t>(level));
+                std::cout << "Level " << level << ", wiper set to: " << static_cast<int>(pot.wiper()) << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+
+            for (int level = 250; level > 0; level -= 5) {
+                brightness.setLevel(static_cast<std::uint8_t>(level));
+                std::cout << "Level " << level << ", wiper set to: " << static_cast<int>(pot.wiper()) << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
         }
+    } catch(const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
-
-    spi_close();
-    
     return 0;
 }
-
-
-
@@ -0,0 +1,168 @@
+/*
+    HC-SR04 ranging written against GpioLines, so the same pipeline runs on live lines or on a recorded trace.
+
+    ./ultrasonic_trace record <file> [pings]        on the Pi: trigger GPIO4, echo GPIO27, everything goes into <file>
+    ./ultrasonic_trace replay <file> [realtime|max|<speed factor>]
+                                                    anywhere: feeds <file> back through GpioLines and times the pipeline
+    ./ultrasonic_trace synth <file> [pings]         writes a fake trace, handy to try replay without the hardware
+
+    The echo line uses edge events instead of polling get_value() like proximity_detection_ultrasonic_sensor.cpp,
+    so the pulse width comes from kernel timestamps and isn't affected by how late the loop wakes up.
+*/
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+
+#include "../Common/gpio_line.hpp"
+#include "../Common/precision_sleep.hpp"
+
+const char *pathname = "/dev/gpiochip0";
+static constexpr auto offsetOutTrigger = std::uint32_t {4};
+static constexpr auto offsetInEcho = std::uint32_t {27};
+static constexpr auto echoTimeoutMs = 30;
+
+struct RangingStats {
+    std::uint64_t pings = 0;
+    std::uint64_t measurements = 0;
+    std::uint64_t timeouts = 0;
+    double sum_cm = 0;
+};
+
+// one ping: 10us trigger pulse, then wait for the rising and falling echo edges
+bool ping(GpioLines &trigger, GpioLines &echo, double &distance_cm, bool live) {
+    trigger.setValue(0, 1);
+    if(live) {
+        PrecisionSleep::waitFor(std::chrono::microseconds(10));
+    }
+    trigger.setValue(0, 0);
+
+    struct gpio_v2_line_event events[16];
+    std::uint64_t rise_ns = 0;
+    while(echo.waitEvent(echoTimeoutMs)) {
+        std::size_t n = echo.readEvents(events, 16);
+        if(n == 0) {
+            return false;
+        }
+        for(std::size_t i = 0; i < n; i++) {
+            if(events[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE) {
+                rise_ns = events[i].timestamp_ns;
+            } else if(rise_ns != 0) {
+                double pulse_us = (events[i].timestamp_ns - rise_ns) / 1000.0;
+                // speed of sound = 34300 cm/s, halved for the round trip
+                distance_cm = pulse_us * 34300.0 / (2 * 1000000);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+RangingStats runRanging(GpioLines &trigger, GpioLines &echo, std::uint64_t pings, bool live) {
+    RangingStats stats;
+    for(std::uint64_t i = 0; i < pings; i++) {
+        double distance = 0;
+        stats.pings++;
+        if(ping(trigger, echo, distance, live)) {
+            stats.measurements++;
+            stats.sum_cm += distance;
+        } else {
+            stats.timeouts++;
+            if(!live && !echo.waitEvent(-1)) {
+                break;  // trace exhausted
+            }
+        }
+        if(live) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        }
+    }
+    return stats;
+}
+
+void printStats(const RangingStats &stats, double seconds) {
+    std::cout << "pings: " << stats.pings << ", measurements: " << stats.measurements
+              << ", timeouts: " << stats.timeouts << std::endl;
+    if(stats.measurements) {
+        std::cout << "mean distance: " << stats.sum_cm / stats.measurements << " cm" << std::endl;
+    }
+    std::cout << "elapsed: " << seconds * 1000.0 << " ms, "
+              << (seconds > 0 ? stats.measurements / seconds : 0) << " measurements/s" << std::endl;
+}
+
+void synthesize(const char *file, std::uint64_t pings) {
+    TraceRecorder recorder(file);
+    std::uint64_t t = traceNowNs();
+    std::uint32_t seqno = 0;
+    for(std::uint64_t i = 0; i < pings; i++) {
+        // 10..200 cm obstacle, 60 ms between pings
+        std::uint64_t echo_ns = (10 + (i * 37) % 190) * 58000ULL;
+        recorder.lineWrite(offsetOutTrigger, 1, 1, t);
+        recorder.lineWrite(offsetOutTrigger, 1, 0, t + 10000);
+        recorder.edge(offsetInEcho, t + 500000, true, offsetInEcho, ++seqno);
+        recorder.edge(offsetInEcho, t + 500000 + echo_ns, false, offsetInEcho, ++seqno);
+        t += 60000000ULL;
+    }
+    recorder.flush();
+    std::cout << "wrote " << recorder.records() << " records, " << recorder.bytes() << " bytes" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 3) {
+        std::cerr << "usage: " << argv[0] << " record|replay|synth <file> [pings|speed]" << std::endl;
+        return 1;
+    }
+    const std::string mode = argv[1];
+    const char *file = argv[2];
+
+    try {
+        if(mode == "synth") {
+            synthesize(file, argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000);
+        } else if(mode == "record") {
+            TraceRecorder recorder(file);
+            GpioLines trigger(pathname, {offsetOutTrigger}, GPIO_V2_LINE_FLAG_OUTPUT, "ultrasonic trigger");
+            GpioLines echo(pathname, {offsetInEcho},
+                           GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING,
+                           "ultrasonic echo");
+            trigger.attachRecorder(&recorder);
+            echo.attachRecorder(&recorder);
+
+            auto start = std::chrono::steady_clock::now();
+            RangingStats stats = runRanging(trigger, echo, argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 200, true);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            recorder.flush();
+            printStats(stats, elapsed.count());
+            std::cout << "trace: " << recorder.records() << " records, " << recorder.bytes() << " bytes" << std::endl;
+        } else if(mode == "replay") {
+            TraceReplayer replayer(file);
+            const std::string speed = argc > 3 ? argv[3] : "max";
+            if(speed == "realtime") {
+                replayer.setSpeed(ReplaySpeed::RealTime);
+            } else if(speed == "max") {
+                replayer.setSpeed(ReplaySpeed::MaxSpeed);
+            } else {
+                replayer.setSpeed(ReplaySpeed::Accelerated, std::strtod(speed.c_str(), nullptr));
+            }
+
+            GpioLines trigger(replayer, {offsetOutTrigger}, offsetOutTrigger);
+            GpioLines echo(replayer, {offsetInEcho}, offsetInEcho);
+
+            replayer.start();
+            auto start = std::chrono::steady_clock::now();
+            RangingStats stats = runRanging(trigger, echo, ~0ULL, false);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            printStats(stats, elapsed.count());
+            std::cout << "trace covers " << replayer.durationNs() / 1e6 << " ms, " << replayer.replayed()
+                      << " of " << replayer.size() << " records replayed" << std::endl;
+        } else {
+            std::cerr << "unknown mode " << mode << std::endl;
+            return 1;
+        }
+    } catch(const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
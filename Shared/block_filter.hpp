@@ -0,0 +1,676 @@
+/*
+    Block filters for ADC sample streams: FIR, biquad cascade (low-pass, high-pass, notch) and moving average,
+    on int16 or float blocks of any length, with state carried from one block to the next.
+
+    Every filter has a scalar reference kernel plus hand-written SIMD kernels, picked at construction time:
+
+        Scalar      plain C++, also what the ESP32 and 32-bit ARM builds use
+        Sse         SSE2, always there on x86-64
+        Avx2        AVX2 + FMA, compiled with target attributes and only chosen if the CPU reports both
+        Neon        AArch64 NEON (64-bit Raspberry Pi OS)
+
+    How the kernels vectorise:
+
+        FIR         across outputs, 8 (SSE / NEON) or 16 (AVX2) outputs per pass, one broadcast tap at a time.
+                    int16 taps are Q15 with int32 accumulation, rounded and saturated on the way out, which the
+                    SIMD versions reproduce bit for bit (the taps' absolute sum must stay below 2 to not overflow).
+        Biquad      an IIR can't be vectorised across samples directly, so each section's response over W samples
+                    (W = 4, or 8 with AVX2) is precomputed as a W x (W + 2) matrix: the output block is that matrix
+                    times (z1, z2, x0 .. xW-1), the state for the next block comes from the last two outputs.
+                    Same result as the scalar recursion up to float rounding, no added latency.
+        Average     running sum as a SIMD prefix sum of (x[i] - x[i - N]) inside a register. Prefix sums don't gain
+                    anything from 256-bit lanes (cross-lane shuffles), so Avx2 uses the SSE kernel.
+
+    Coefficient design (RBJ cookbook biquads, Hamming windowed-sinc FIR) is in here too.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define FILTER_HAVE_SSE 1
+#if defined(__GNUC__) || defined(__clang__)
+#define FILTER_HAVE_AVX2 1
+#define FILTER_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FILTER_HAVE_NEON 1
+#endif
+
+enum class FilterIsa {
+    Scalar,
+    Sse,
+    Avx2,
+    Neon
+};
+
+inline bool filterIsaSupported(FilterIsa isa) {
+    switch(isa) {
+    case FilterIsa::Scalar:
+        return true;
+    case FilterIsa::Sse:
+#ifdef FILTER_HAVE_SSE
+        return true;
+#else
+        return false;
+#endif
+    case FilterIsa::Avx2:
+#ifdef FILTER_HAVE_AVX2
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+        return false;
+#endif
+    case FilterIsa::Neon:
+#ifdef FILTER_HAVE_NEON
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+inline FilterIsa bestFilterIsa() {
+    for(FilterIsa isa : {FilterIsa::Avx2, FilterIsa::Sse, FilterIsa::Neon}) {
+        if(filterIsaSupported(isa)) {
+            return isa;
+        }
+    }
+    return FilterIsa::Scalar;
+}
+
+inline const char *filterIsaName(FilterIsa isa) {
+    switch(isa) {
+    case FilterIsa::Scalar: return "scalar";
+    case FilterIsa::Sse:    return "SSE2";
+    case FilterIsa::Avx2:   return "AVX2";
+    case FilterIsa::Neon:   return "NEON";
+    }
+    return "?";
+}
+
+struct BiquadCoeffs {
+    float b0, b1, b2, a1, a2;   // normalised to a0 = 1
+
+    static BiquadCoeffs lowpass(double fs, double f0, double q = 0.7071) {
+        double w = 2 * M_PI * f0 / fs, alpha = std::sin(w) / (2 * q), c = std::cos(w), a0 = 1 + alpha;
+        return {float((1 - c) / 2 / a0), float((1 - c) / a0), float((1 - c) / 2 / a0), float(-2 * c / a0), float((1 - alpha) / a0)};
+    }
+
+    static BiquadCoeffs highpass(double fs, double f0, double q = 0.7071) {
+        double w = 2 * M_PI * f0 / fs, alpha = std::sin(w) / (2 * q), c = std::cos(w), a0 = 1 + alpha;
+        return {float((1 + c) / 2 / a0), float(-(1 + c) / a0), float((1 + c) / 2 / a0), float(-2 * c / a0), float((1 - alpha) / a0)};
+    }
+
+    // q around 5-30 for mains hum, higher is narrower
+    static BiquadCoeffs notch(double fs, double f0, double q = 10) {
+        double w = 2 * M_PI * f0 / fs, alpha = std::sin(w) / (2 * q), c = std::cos(w), a0 = 1 + alpha;
+        return {float(1 / a0), float(-2 * c / a0), float(1 / a0), float(-2 * c / a0), float((1 - alpha) / a0)};
+    }
+};
+
+// Windowed-sinc low-pass taps (Hamming), unity gain at DC
+inline std::vector<float> lowpassFirTaps(std::size_t ntaps, double fs, double cutoff) {
+    std::vector<float> taps(ntaps);
+    double fc = cutoff / fs, mid = (ntaps - 1) / 2.0, sum = 0;
+    for(std::size_t i = 0; i < ntaps; i++) {
+        double t = i - mid;
+        double sinc = t == 0 ? 2 * fc : std::sin(2 * M_PI * fc * t) / (M_PI * t);
+        double window = ntaps > 1 ? 0.54 - 0.46 * std::cos(2 * M_PI * i / (ntaps - 1)) : 1.0;
+        taps[i] = static_cast<float>(sinc * window);
+        sum += taps[i];
+    }
+    for(auto &t : taps) {
+        t = static_cast<float>(t / sum);
+    }
+    return taps;
+}
+
+namespace filter_detail {
+
+static constexpr std::size_t chunk = 256;   // samples per kernel call, bounds the internal buffers
+
+inline std::int16_t saturate16(std::int32_t v) {
+    return static_cast<std::int16_t>(std::min<std::int32_t>(32767, std::max<std::int32_t>(-32768, v)));
+}
+
+inline std::int16_t q15Round(std::int32_t acc) {
+    return saturate16((acc + (1 << 14)) >> 15);
+}
+
+// ---- FIR: out[i] = sum_k taps[k] * x[i + k], taps reversed, x holds ntaps - 1 + n samples ----
+
+inline void firScalar(const float *x, const float *taps, std::size_t ntaps, float *out, std::size_t n) {
+    for(std::size_t i = 0; i < n; i++) {
+        float acc = 0;
+        for(std::size_t k = 0; k < ntaps; k++) {
+            acc += taps[k] * x[i + k];
+        }
+        out[i] = acc;
+    }
+}
+
+inline void firScalar(const std::int16_t *x, const std::int16_t *taps, std::size_t ntaps, std::int16_t *out, std::size_t n) {
+    for(std::size_t i = 0; i < n; i++) {
+        std::int32_t acc = 0;
+        for(std::size_t k = 0; k < ntaps; k++) {
+            acc += static_cast<std::int32_t>(taps[k]) * x[i + k];
+        }
+        out[i] = q15Round(acc);
+    }
+}
+
+// two int16 taps in one int32 lane for pmaddwd
+inline std::int32_t tapPair(const std::int16_t *taps, std::size_t k) {
+    return static_cast<std::int32_t>(static_cast<std::uint16_t>(taps[k]) | (static_cast<std::uint32_t>(static_cast<std::uint16_t>(taps[k + 1])) << 16));
+}
+
+#ifdef FILTER_HAVE_SSE
+inline void firSse(const float *x, const float *taps, std::size_t ntaps, float *out, std::size_t n) {
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+        for(std::size_t k = 0; k < ntaps; k++) {
+            __m128 h = _mm_set1_ps(taps[k]);
+            a0 = _mm_add_ps(a0, _mm_mul_ps(h, _mm_loadu_ps(x + i + k)));
+            a1 = _mm_add_ps(a1, _mm_mul_ps(h, _mm_loadu_ps(x + i + k + 4)));
+        }
+        _mm_storeu_ps(out + i, a0);
+        _mm_storeu_ps(out + i + 4, a1);
+    }
+    firScalar(x + i, taps, ntaps, out + i, n - i);
+}
+
+// ntaps must be even (FirFilter pads with a leading zero tap)
+inline void firSse(const std::int16_t *x, const std::int16_t *taps, std::size_t ntaps, std::int16_t *out, std::size_t n) {
+    const __m128i round = _mm_set1_epi32(1 << 14);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        for(std::size_t k = 0; k < ntaps; k += 2) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i + k));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i + k + 1));
+            __m128i h = _mm_set1_epi32(tapPair(taps, k));
+            // (x[i+j+k], x[i+j+k+1]) pairs against (taps[k], taps[k+1])
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), h));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), h));
+        }
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 15);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 15);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(lo, hi));
+    }
+    firScalar(x + i, taps, ntaps, out + i, n - i);
+}
+#endif
+
+#ifdef FILTER_HAVE_AVX2
+FILTER_AVX2_TARGET inline void firAvx2(const float *x, const float *taps, std::size_t ntaps, float *out, std::size_t n) {
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        for(std::size_t k = 0; k < ntaps; k++) {
+            __m256 h = _mm256_set1_ps(taps[k]);
+            a0 = _mm256_fmadd_ps(h, _mm256_loadu_ps(x + i + k), a0);
+            a1 = _mm256_fmadd_ps(h, _mm256_loadu_ps(x + i + k + 8), a1);
+        }
+        _mm256_storeu_ps(out + i, a0);
+        _mm256_storeu_ps(out + i + 8, a1);
+    }
+    firScalar(x + i, taps, ntaps, out + i, n - i);
+}
+
+FILTER_AVX2_TARGET inline void firAvx2(const std::int16_t *x, const std::int16_t *taps, std::size_t ntaps, std::int16_t *out, std::size_t n) {
+    const __m256i round = _mm256_set1_epi32(1 << 14);
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        // unpack works per 128-bit lane: lo holds outputs 0-3 and 8-11, hi 4-7 and 12-15
+        __m256i lo = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+        for(std::size_t k = 0; k < ntaps; k += 2) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i + k));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i + k + 1));
+            __m256i h = _mm256_set1_epi32(tapPair(taps, k));
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), h));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), h));
+        }
+        lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), 15);
+        hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), 15);
+        // the per-lane pack puts them back in order
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_packs_epi32(lo, hi));
+    }
+    firScalar(x + i, taps, ntaps, out + i, n - i);
+}
+#endif
+
+#ifdef FILTER_HAVE_NEON
+inline void firNeon(const float *x, const float *taps, std::size_t ntaps, float *out, std::size_t n) {
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        float32x4_t a0 = vdupq_n_f32(0), a1 = vdupq_n_f32(0);
+        for(std::size_t k = 0; k < ntaps; k++) {
+            a0 = vfmaq_n_f32(a0, vld1q_f32(x + i + k), taps[k]);
+            a1 = vfmaq_n_f32(a1, vld1q_f32(x + i + k + 4), taps[k]);
+        }
+        vst1q_f32(out + i, a0);
+        vst1q_f32(out + i + 4, a1);
+    }
+    firScalar(x + i, taps, ntaps, out + i, n - i);
+}
+
+inline void firNeon(const std::int16_t *x, const std::int16_t *taps, std::size_t ntaps, std::int16_t *out, std::size_t n) {
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        int32x4_t lo = vdupq_n_s32(0), hi = vdupq_n_s32(0);
+        for(std::size_t k = 0; k < ntaps; k++) {
+            int16x8_t v = vld1q_s16(x + i + k);
+            lo = vmlal_n_s16(lo, vget_low_s16(v), taps[k]);
+            hi = vmlal_n_s16(hi, vget_high_s16(v), taps[k]);
+        }
+        // rounding, saturating narrow: same as q15Round()
+        vst1q_s16(out + i, vcombine_s16(vqrshrn_n_s32(lo, 15), vqrshrn_n_s32(hi, 15)));
+    }
+    firScalar(x + i, taps, ntaps, out + i, n - i);
+}
+#endif
+
+// ---- Biquad section, transposed direct form II, in place ----
+
+struct BiquadState {
+    float z1 = 0, z2 = 0;
+};
+
+inline void biquadScalar(const BiquadCoeffs &c, BiquadState &s, float *x, std::size_t n) {
+    float z1 = s.z1, z2 = s.z2;
+    for(std::size_t i = 0; i < n; i++) {
+        float in = x[i];
+        float y = c.b0 * in + z1;
+        z1 = c.b1 * in - c.a1 * y + z2;
+        z2 = c.b2 * in - c.a2 * y;
+        x[i] = y;
+    }
+    s.z1 = z1;
+    s.z2 = z2;
+}
+
+// Columns of the block matrix for W samples: response to z1 = 1, to z2 = 1, then to a unit sample at each position
+inline std::vector<float> biquadBlockMatrix(const BiquadCoeffs &c, std::size_t w) {
+    std::vector<float> m((w + 2) * w);
+    for(std::size_t col = 0; col < w + 2; col++) {
+        BiquadState s;
+        std::vector<float> x(w, 0.0f);
+        if(col == 0) {
+            s.z1 = 1;
+        } else if(col == 1) {
+            s.z2 = 1;
+        } else {
+            x[col - 2] = 1;
+        }
+        biquadScalar(c, s, x.data(), w);
+        std::copy(x.begin(), x.end(), m.begin() + col * w);
+    }
+    return m;
+}
+
+// State after a block from its last two inputs and outputs
+inline void biquadCarry(const BiquadCoeffs &c, BiquadState &s, float xp, float xl, float yp, float yl) {
+    s.z2 = c.b2 * xl - c.a2 * yl;
+    s.z1 = c.b1 * xl - c.a1 * yl + c.b2 * xp - c.a2 * yp;
+}
+
+#ifdef FILTER_HAVE_SSE
+inline void biquadSse(const BiquadCoeffs &c, const float *m, BiquadState &s, float *x, std::size_t n) {
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        float xp = x[i + 2], xl = x[i + 3];
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.z1), _mm_loadu_ps(m)), _mm_mul_ps(_mm_set1_ps(s.z2), _mm_loadu_ps(m + 4)));
+        for(std::size_t j = 0; j < 4; j++) {
+            y = _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(x[i + j]), _mm_loadu_ps(m + 8 + 4 * j)));
+        }
+        _mm_storeu_ps(x + i, y);
+        biquadCarry(c, s, xp, xl, x[i + 2], x[i + 3]);
+    }
+    biquadScalar(c, s, x + i, n - i);
+}
+#endif
+
+#ifdef FILTER_HAVE_AVX2
+FILTER_AVX2_TARGET inline void biquadAvx2(const BiquadCoeffs &c, const float *m, BiquadState &s, float *x, std::size_t n) {
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        float xp = x[i + 6], xl = x[i + 7];
+        __m256 y = _mm256_mul_ps(_mm256_set1_ps(s.z1), _mm256_loadu_ps(m));
+        y = _mm256_fmadd_ps(_mm256_set1_ps(s.z2), _mm256_loadu_ps(m + 8), y);
+        for(std::size_t j = 0; j < 8; j++) {
+            y = _mm256_fmadd_ps(_mm256_broadcast_ss(x + i + j), _mm256_loadu_ps(m + 16 + 8 * j), y);
+        }
+        _mm256_storeu_ps(x + i, y);
+        biquadCarry(c, s, xp, xl, x[i + 6], x[i + 7]);
+    }
+    biquadScalar(c, s, x + i, n - i);
+}
+#endif
+
+#ifdef FILTER_HAVE_NEON
+inline void biquadNeon(const BiquadCoeffs &c, const float *m, BiquadState &s, float *x, std::size_t n) {
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        float xp = x[i + 2], xl = x[i + 3];
+        float32x4_t in = vld1q_f32(x + i);
+        float32x4_t y = vmulq_n_f32(vld1q_f32(m), s.z1);
+        y = vfmaq_n_f32(y, vld1q_f32(m + 4), s.z2);
+        y = vfmaq_laneq_f32(y, vld1q_f32(m + 8), in, 0);
+        y = vfmaq_laneq_f32(y, vld1q_f32(m + 12), in, 1);
+        y = vfmaq_laneq_f32(y, vld1q_f32(m + 16), in, 2);
+        y = vfmaq_laneq_f32(y, vld1q_f32(m + 20), in, 3);
+        vst1q_f32(x + i, y);
+        biquadCarry(c, s, xp, xl, x[i + 2], x[i + 3]);
+    }
+    biquadScalar(c, s, x + i, n - i);
+}
+#endif
+
+// ---- Moving average: x[-n..-1] is the previous window, sum is carried between calls ----
+
+inline void averageScalar(const std::int16_t *x, std::size_t window, std::int32_t &sum, float inv, std::int16_t *out, std::size_t n) {
+    for(std::size_t i = 0; i < n; i++) {
+        sum += x[i] - x[static_cast<std::ptrdiff_t>(i) - static_cast<std::ptrdiff_t>(window)];
+        out[i] = saturate16(static_cast<std::int32_t>(std::nearbyint(sum * inv)));
+    }
+}
+
+inline void averageScalar(const float *x, std::size_t window, float &sum, float inv, float *out, std::size_t n) {
+    for(std::size_t i = 0; i < n; i++) {
+        sum += x[i] - x[static_cast<std::ptrdiff_t>(i) - static_cast<std::ptrdiff_t>(window)];
+        out[i] = sum * inv;
+    }
+}
+
+#ifdef FILTER_HAVE_SSE
+inline __m128i widen16(const std::int16_t *p) {
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+    return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);    // SSE2 has no pmovsxwd
+}
+
+inline void averageSse(const std::int16_t *x, std::size_t window, std::int32_t &sum, float inv, std::int16_t *out, std::size_t n) {
+    const __m128 scale = _mm_set1_ps(inv);
+    __m128i carry = _mm_set1_epi32(sum);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m128i d = _mm_sub_epi32(widen16(x + i), widen16(x + i - window));
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+        __m128i s = _mm_add_epi32(d, carry);
+        carry = _mm_shuffle_epi32(s, 0xFF);
+        __m128i r = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(r, r));
+    }
+    sum = _mm_cvtsi128_si32(carry);
+    averageScalar(x + i, window, sum, inv, out + i, n - i);
+}
+
+inline void averageSse(const float *x, std::size_t window, float &sum, float inv, float *out, std::size_t n) {
+    const __m128 scale = _mm_set1_ps(inv);
+    __m128 carry = _mm_set1_ps(sum);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(x + i - window));
+        d = _mm_add_ps(d, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(d), 4)));
+        d = _mm_add_ps(d, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(d), 8)));
+        __m128 s = _mm_add_ps(d, carry);
+        carry = _mm_shuffle_ps(s, s, 0xFF);
+        _mm_storeu_ps(out + i, _mm_mul_ps(s, scale));
+    }
+    sum = _mm_cvtss_f32(carry);
+    averageScalar(x + i, window, sum, inv, out + i, n - i);
+}
+#endif
+
+#ifdef FILTER_HAVE_NEON
+inline void averageNeon(const std::int16_t *x, std::size_t window, std::int32_t &sum, float inv, std::int16_t *out, std::size_t n) {
+    const int32x4_t zero = vdupq_n_s32(0);
+    int32x4_t carry = vdupq_n_s32(sum);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        int32x4_t d = vsubl_s16(vld1_s16(x + i), vld1_s16(x + i - window));
+        d = vaddq_s32(d, vextq_s32(zero, d, 3));
+        d = vaddq_s32(d, vextq_s32(zero, d, 2));
+        int32x4_t s = vaddq_s32(d, carry);
+        carry = vdupq_laneq_s32(s, 3);
+        int32x4_t r = vcvtnq_s32_f32(vmulq_n_f32(vcvtq_f32_s32(s), inv));
+        vst1_s16(out + i, vqmovn_s32(r));
+    }
+    sum = vgetq_lane_s32(carry, 0);
+    averageScalar(x + i, window, sum, inv, out + i, n - i);
+}
+
+inline void averageNeon(const float *x, std::size_t window, float &sum, float inv, float *out, std::size_t n) {
+    const float32x4_t zero = vdupq_n_f32(0);
+    float32x4_t carry = vdupq_n_f32(sum);
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        float32x4_t d = vsubq_f32(vld1q_f32(x + i), vld1q_f32(x + i - window));
+        d = vaddq_f32(d, vextq_f32(zero, d, 3));
+        d = vaddq_f32(d, vextq_f32(zero, d, 2));
+        float32x4_t s = vaddq_f32(d, carry);
+        carry = vdupq_laneq_f32(s, 3);
+        vst1q_f32(out + i, vmulq_n_f32(s, inv));
+    }
+    sum = vgetq_lane_f32(carry, 0);
+    averageScalar(x + i, window, sum, inv, out + i, n - i);
+}
+#endif
+
+}   // namespace filter_detail
+
+// T is float or std::int16_t (Q15 taps, full-scale int16 samples)
+template <typename T>
+class FirFilter {
+private:
+    std::vector<T> taps_;       // reversed (oldest sample first), even length for the int16 pair kernels
+    std::vector<T> buf_;        // taps - 1 samples of history, then the current chunk
+    FilterIsa isa_;
+
+    void kernel(const T *x, T *out, std::size_t n) const {
+        switch(isa_) {
+#ifdef FILTER_HAVE_SSE
+        case FilterIsa::Sse:
+            filter_detail::firSse(x, taps_.data(), taps_.size(), out, n);
+            return;
+#endif
+#ifdef FILTER_HAVE_AVX2
+        case FilterIsa::Avx2:
+            filter_detail::firAvx2(x, taps_.data(), taps_.size(), out, n);
+            return;
+#endif
+#ifdef FILTER_HAVE_NEON
+        case FilterIsa::Neon:
+            filter_detail::firNeon(x, taps_.data(), taps_.size(), out, n);
+            return;
+#endif
+        default:
+            filter_detail::firScalar(x, taps_.data(), taps_.size(), out, n);
+            return;
+        }
+    }
+
+public:
+    explicit FirFilter(const std::vector<float> &taps, FilterIsa isa = bestFilterIsa())
+        : isa_(filterIsaSupported(isa) ? isa : FilterIsa::Scalar)
+    {
+        std::size_t padded = taps.size() + (taps.size() % 2);
+        taps_.assign(padded, T(0));
+        for(std::size_t k = 0; k < taps.size(); k++) {
+            float t = taps[taps.size() - 1 - k];
+            if constexpr(std::is_same<T, std::int16_t>::value) {
+                taps_[padded - taps.size() + k] = filter_detail::saturate16(static_cast<std::int32_t>(std::lround(t * 32768.0f)));
+            } else {
+                taps_[padded - taps.size() + k] = t;
+            }
+        }
+        buf_.assign(taps_.size() - 1 + filter_detail::chunk, T(0));
+    }
+
+    // in and out may be the same buffer
+    void process(const T *in, T *out, std::size_t n) {
+        const std::size_t history = taps_.size() - 1;
+        while(n > 0) {
+            std::size_t m = std::min(n, filter_detail::chunk);
+            std::memcpy(buf_.data() + history, in, m * sizeof(T));
+            kernel(buf_.data(), out, m);
+            std::memmove(buf_.data(), buf_.data() + m, history * sizeof(T));
+            in += m;
+            out += m;
+            n -= m;
+        }
+    }
+
+    void reset() { std::fill(buf_.begin(), buf_.end(), T(0)); }
+    FilterIsa isa() const { return isa_; }
+};
+
+template <typename T>
+class BiquadCascade {
+private:
+    std::vector<BiquadCoeffs> sections_;
+    std::vector<filter_detail::BiquadState> state_;
+    std::vector<std::vector<float>> matrices_;
+    std::vector<float> work_;
+    FilterIsa isa_;
+
+    void run(float *x, std::size_t n) {
+        for(std::size_t s = 0; s < sections_.size(); s++) {
+            switch(isa_) {
+#ifdef FILTER_HAVE_SSE
+            case FilterIsa::Sse:
+                filter_detail::biquadSse(sections_[s], matrices_[s].data(), state_[s], x, n);
+                break;
+#endif
+#ifdef FILTER_HAVE_AVX2
+            case FilterIsa::Avx2:
+                filter_detail::biquadAvx2(sections_[s], matrices_[s].data(), state_[s], x, n);
+                break;
+#endif
+#ifdef FILTER_HAVE_NEON
+            case FilterIsa::Neon:
+                filter_detail::biquadNeon(sections_[s], matrices_[s].data(), state_[s], x, n);
+                break;
+#endif
+            default:
+                filter_detail::biquadScalar(sections_[s], state_[s], x, n);
+                break;
+            }
+        }
+    }
+
+public:
+    explicit BiquadCascade(const std::vector<BiquadCoeffs> &sections, FilterIsa isa = bestFilterIsa())
+        : sections_(sections), state_(sections.size()), work_(filter_detail::chunk),
+          isa_(filterIsaSupported(isa) ? isa : FilterIsa::Scalar)
+    {
+        if(isa_ != FilterIsa::Scalar) {
+            for(const auto &c : sections_) {
+                matrices_.push_back(filter_detail::biquadBlockMatrix(c, isa_ == FilterIsa::Avx2 ? 8 : 4));
+            }
+        }
+    }
+
+    // in and out may be the same buffer
+    void process(const T *in, T *out, std::size_t n) {
+        while(n > 0) {
+            std::size_t m = std::min(n, filter_detail::chunk);
+            for(std::size_t i = 0; i < m; i++) {
+                work_[i] = static_cast<float>(in[i]);
+            }
+            run(work_.data(), m);
+            for(std::size_t i = 0; i < m; i++) {
+                if constexpr(std::is_same<T, std::int16_t>::value) {
+                    out[i] = filter_detail::saturate16(static_cast<std::int32_t>(std::lrint(work_[i])));
+                } else {
+                    out[i] = work_[i];
+                }
+            }
+            in += m;
+            out += m;
+            n -= m;
+        }
+    }
+
+    void reset() { std::fill(state_.begin(), state_.end(), filter_detail::BiquadState()); }
+    FilterIsa isa() const { return isa_; }
+};
+
+template <typename T>
+class MovingAverage {
+private:
+    using Sum = typename std::conditional<std::is_same<T, std::int16_t>::value, std::int32_t, float>::type;
+
+    std::size_t window_;
+    float inv_;
+    Sum sum_ = 0;
+    std::vector<T> buf_;        // window samples of history, then the current chunk
+    FilterIsa isa_;
+
+    void kernel(const T *x, T *out, std::size_t n) {
+        switch(isa_) {
+#ifdef FILTER_HAVE_SSE
+        case FilterIsa::Sse:
+        case FilterIsa::Avx2:
+            filter_detail::averageSse(x, window_, sum_, inv_, out, n);
+            return;
+#endif
+#ifdef FILTER_HAVE_NEON
+        case FilterIsa::Neon:
+            filter_detail::averageNeon(x, window_, sum_, inv_, out, n);
+            return;
+#endif
+        default:
+            filter_detail::averageScalar(x, window_, sum_, inv_, out, n);
+            return;
+        }
+    }
+
+public:
+    explicit MovingAverage(std::size_t window, FilterIsa isa = bestFilterIsa())
+        : window_(window ? window : 1), inv_(1.0f / (window ? window : 1)),
+          buf_((window ? window : 1) + filter_detail::chunk, T(0)),
+          isa_(filterIsaSupported(isa) ? isa : FilterIsa::Scalar)
+    {
+    }
+
+    // in and out may be the same buffer
+    void process(const T *in, T *out, std::size_t n) {
+        while(n > 0) {
+            std::size_t m = std::min(n, filter_detail::chunk);
+            std::memcpy(buf_.data() + window_, in, m * sizeof(T));
+            kernel(buf_.data() + window_, out, m);
+            std::memmove(buf_.data(), buf_.data() + m, window_ * sizeof(T));
+            if constexpr(!std::is_same<T, std::int16_t>::value) {
+                // the float running sum drifts, recompute it from the window once per chunk
+                double exact = 0;
+                for(std::size_t i = 0; i < window_; i++) {
+                    exact += buf_[i];
+                }
+                sum_ = static_cast<float>(exact);
+            }
+            in += m;
+            out += m;
+            n -= m;
+        }
+    }
+
+    void reset() {
+        std::fill(buf_.begin(), buf_.end(), T(0));
+        sum_ = 0;
+    }
+    FilterIsa isa() const { return isa_; }
+};
@@ -0,0 +1,119 @@
+/*
+    Light reading to LED brightness through a gamma table, shared by the ESP32 LEDC output
+    (ESP32/C++/ledc_fade_output.hpp), the MCP41010 wiper and a PCA9685 channel on the Pi (Common/mcp41010.hpp,
+    Common/pca9685.hpp).
+
+    The eye sees brightness roughly as duty^(1/2.2), so a linear ramp spends most of its steps looking almost full
+    and jumps at the dark end. GammaCurve maps a perceived level 0-255 to output counts with
+    counts = max_counts * (level / 255)^gamma, computed once into a 256-entry table. With the 13-bit LEDC duty even
+    the lowest levels get their own step; on the 8-bit MCP41010 wiper the bottom ~25 levels share the first few
+    wiper positions, that's the resolution of the chip.
+
+    BrightnessController<Output> turns a light reading into a level (255 at dark_reading, 0 at lit_reading, linear in
+    between and clamped, either may be the larger one depending on how the LDR divider is wired), looks up the
+    counts and hands them to the output:
+
+        std::uint32_t maxCounts() const                 full brightness
+        bool fadeTo(std::uint32_t counts, std::uint32_t fade_ms)
+                                                        false if the output can't take a new target yet
+
+    LEDC fades in hardware, so between two updates the CPU does nothing. The MCP41010 and PCA9685 have no fade, their
+    fadeTo() sets the wiper or duty at once and the smoothing comes from the update rate. Levels within deadband of
+    the current one are ignored, so a noisy reading doesn't restart the fade on every update.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <array>
+
+class GammaCurve {
+private:
+    std::array<std::uint16_t, 256> counts_;
+    std::uint32_t max_counts_;
+
+public:
+    explicit GammaCurve(std::uint32_t max_counts, float gamma = 2.2f)
+        : max_counts_(max_counts > 0xFFFF ? 0xFFFF : max_counts)
+    {
+        for(std::size_t level = 0; level < counts_.size(); level++) {
+            float c = max_counts_ * std::pow(level / 255.0f, gamma);
+            counts_[level] = static_cast<std::uint16_t>(std::lround(c));
+        }
+    }
+
+    std::uint16_t operator[](std::uint8_t level) const { return counts_[level]; }
+    std::uint32_t maxCounts() const { return max_counts_; }
+};
+
+template <typename Output>
+class BrightnessController {
+private:
+    Output &output_;
+    GammaCurve curve_;
+    std::uint32_t dark_reading_;
+    std::uint32_t lit_reading_;
+    std::uint32_t fade_ms_;
+    unsigned deadband_;
+    int level_ = -1;                // last level the output accepted, -1 before the first
+    std::uint32_t updates_ = 0;
+    std::uint32_t changes_ = 0;
+
+    // Prevent copying
+    BrightnessController(const BrightnessController&) = delete;
+    BrightnessController& operator=(const BrightnessController&) = delete;
+
+public:
+    // fade_ms: how long the output takes to reach a new level, keep it below the update period
+    BrightnessController(Output &output, std::uint32_t dark_reading, std::uint32_t lit_reading,
+                         std::uint32_t fade_ms, float gamma = 2.2f, unsigned deadband = 2)
+        : output_(output), curve_(output.maxCounts(), gamma), dark_reading_(dark_reading),
+          lit_reading_(lit_reading), fade_ms_(fade_ms), deadband_(deadband)
+    {
+    }
+
+    std::uint8_t levelFor(std::uint32_t reading) const {
+        if(dark_reading_ == lit_reading_) {
+            return 0;
+        }
+        std::int64_t span = static_cast<std::int64_t>(dark_reading_) - lit_reading_;
+        std::int64_t pos = static_cast<std::int64_t>(reading) - lit_reading_;
+        std::int64_t level = (pos * 255 + span / 2) / span;
+        return static_cast<std::uint8_t>(level < 0 ? 0 : level > 255 ? 255 : level);
+    }
+
+    // Call once per reading, true if a new level went to the output
+    bool update(std::uint32_t reading) {
+        updates_++;
+        return setLevel(levelFor(reading));
+    }
+
+    bool setLevel(std::uint8_t level) {
+        if(level_ >= 0) {
+            unsigned diff = level > level_ ? level - level_ : level_ - level;
+            // fully off and fully on are always reached, whatever the deadband
+            bool edge = (level == 0 || level == 255) && level != level_;
+            if(diff < deadband_ && !edge) {
+                return false;
+            }
+            if(diff == 0) {
+                return false;
+            }
+        }
+        if(!output_.fadeTo(curve_[level], fade_ms_)) {
+            return false;
+        }
+        level_ = level;
+        changes_++;
+        return true;
+    }
+
+    // Last level / counts handed to the output, 0 before the first update
+    std::uint8_t level() const { return level_ < 0 ? 0 : static_cast<std::uint8_t>(level_); }
+    std::uint16_t counts() const { return curve_[level()]; }
+    std::uint32_t updates() const { return updates_; }
+    std::uint32_t changes() const { return changes_; }
+    const GammaCurve &curve() const { return curve_; }
+};
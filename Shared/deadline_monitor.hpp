@@ -0,0 +1,242 @@
+/*
+    Deadline monitor for periodic loops, on Linux (Pi) and FreeRTOS (ESP32) builds.
+
+    A loop owns one DeadlineMonitor and brackets its work with start() / finish():
+
+        DeadlineMonitor monitor("blink", 500000);
+        while(true) {
+            monitor.start();
+            ... work ...
+            monitor.finish();
+            vTaskDelay(pdMS_TO_TICKS(500));
+        }
+
+    start() measures the actual period (time since the previous start) and how late the iteration began against
+    its intended start, finish() the execution time. An iteration starting more than tolerance_us late is an
+    overrun. The intended start is either the previous start + period (Relative, for sleep_for / vTaskDelay loops,
+    where every late wake-up shifts the rest) or a fixed grid from the first start (Absolute, for sleep_until /
+    xTaskDelayUntil loops that catch up).
+
+    Every monitor registers itself in a small global table, so the numbers of all loops can be printed from
+    anywhere with DeadlineMonitor::report(). reportIfRequested() prints them on demand: after SIGUSR1 on Linux
+    (kill -USR1 <pid>, enableReportTrigger() installs the handler) or after a 'd' typed on the ESP32 console.
+    Counters are relaxed atomics, a report from another thread sees each number whole but maybe one iteration apart.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <atomic>
+#include <array>
+#include <algorithm>
+
+#if defined(ESP_PLATFORM)
+extern "C" {
+#include "esp_timer.h"
+}
+#else
+#include <csignal>
+#include <time.h>
+#endif
+
+enum class DeadlineSchedule {
+    Relative,
+    Absolute
+};
+
+struct DeadlineStats {
+    const char *name;
+    std::uint32_t period_us;
+    std::uint32_t iterations;
+    std::uint32_t overruns;
+    std::int64_t worst_lateness_us;
+    std::int64_t min_period_us;         // actual periods, from the second iteration on
+    std::int64_t mean_period_us;
+    std::int64_t max_period_us;
+    std::int64_t mean_exec_us;
+    std::int64_t max_exec_us;
+};
+
+namespace deadline_detail {
+
+inline std::int64_t nowUs() {
+#if defined(ESP_PLATFORM)
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+template <typename T>
+void storeMax(std::atomic<T> &slot, T value) {
+    if(value > slot.load(std::memory_order_relaxed)) {
+        slot.store(value, std::memory_order_relaxed);
+    }
+}
+
+#if !defined(ESP_PLATFORM)
+inline volatile std::sig_atomic_t reportSignalled = 0;
+
+inline void onReportSignal(int) {
+    reportSignalled = 1;
+}
+#endif
+
+}
+
+class DeadlineMonitor {
+public:
+    static constexpr std::size_t maxMonitors = 16;
+
+private:
+    static inline std::array<std::atomic<DeadlineMonitor *>, maxMonitors> registry_{};
+
+    const char *name_;
+    std::uint32_t period_us_;
+    std::uint32_t tolerance_us_;
+    DeadlineSchedule schedule_;
+    // only the owning loop writes these
+    std::int64_t first_start_ = -1;
+    std::int64_t last_start_ = -1;
+    std::int64_t intended_ = 0;
+    // read by report() from any thread
+    std::atomic<std::uint32_t> iterations_{0};
+    std::atomic<std::uint32_t> overruns_{0};
+    std::atomic<std::int64_t> worst_lateness_us_{0};
+    std::atomic<std::int64_t> min_period_us_{0};
+    std::atomic<std::int64_t> max_period_us_{0};
+    std::atomic<std::int64_t> span_us_{0};          // first start to last start
+    std::atomic<std::int64_t> exec_total_us_{0};
+    std::atomic<std::int64_t> max_exec_us_{0};
+    std::atomic<std::uint32_t> finished_{0};
+
+    // Prevent copying
+    DeadlineMonitor(const DeadlineMonitor&) = delete;
+    DeadlineMonitor& operator=(const DeadlineMonitor&) = delete;
+
+public:
+    // tolerance_us: how late an iteration may start before it counts as an overrun, default a tenth of the period
+    DeadlineMonitor(const char *name, std::uint32_t period_us, DeadlineSchedule schedule = DeadlineSchedule::Relative,
+                    std::uint32_t tolerance_us = 0)
+        : name_(name), period_us_(period_us), tolerance_us_(tolerance_us ? tolerance_us : period_us / 10),
+          schedule_(schedule)
+    {
+        for(auto &slot : registry_) {
+            DeadlineMonitor *expected = nullptr;
+            if(slot.compare_exchange_strong(expected, this)) {
+                break;
+            }
+        }
+    }
+
+    ~DeadlineMonitor() {
+        for(auto &slot : registry_) {
+            DeadlineMonitor *expected = this;
+            slot.compare_exchange_strong(expected, nullptr);
+        }
+    }
+
+    // Top of the iteration, right after the wait
+    void start() {
+        const std::int64_t now = deadline_detail::nowUs();
+        if(last_start_ < 0) {
+            first_start_ = now;
+            intended_ = now;
+        } else {
+            std::int64_t period = now - last_start_;
+            intended_ = schedule_ == DeadlineSchedule::Absolute ? intended_ + period_us_ : last_start_ + period_us_;
+            std::int64_t late = now - intended_;
+            if(late > static_cast<std::int64_t>(tolerance_us_)) {
+                overruns_.fetch_add(1, std::memory_order_relaxed);
+            }
+            deadline_detail::storeMax(worst_lateness_us_, late);
+            deadline_detail::storeMax(max_period_us_, period);
+            if(iterations_.load(std::memory_order_relaxed) == 1 || period < min_period_us_.load(std::memory_order_relaxed)) {
+                min_period_us_.store(period, std::memory_order_relaxed);
+            }
+            span_us_.store(now - first_start_, std::memory_order_relaxed);
+        }
+        last_start_ = now;
+        iterations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // End of the work, before the wait
+    void finish() {
+        std::int64_t exec = deadline_detail::nowUs() - last_start_;
+        exec_total_us_.fetch_add(exec, std::memory_order_relaxed);
+        deadline_detail::storeMax(max_exec_us_, exec);
+        finished_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    DeadlineStats stats() const {
+        DeadlineStats s;
+        s.name = name_;
+        s.period_us = period_us_;
+        s.iterations = iterations_.load(std::memory_order_relaxed);
+        s.overruns = overruns_.load(std::memory_order_relaxed);
+        s.worst_lateness_us = worst_lateness_us_.load(std::memory_order_relaxed);
+        s.min_period_us = min_period_us_.load(std::memory_order_relaxed);
+        s.max_period_us = max_period_us_.load(std::memory_order_relaxed);
+        s.mean_period_us = s.iterations > 1 ? span_us_.load(std::memory_order_relaxed) / (s.iterations - 1) : 0;
+        std::uint32_t finished = finished_.load(std::memory_order_relaxed);
+        s.mean_exec_us = finished ? exec_total_us_.load(std::memory_order_relaxed) / finished : 0;
+        s.max_exec_us = max_exec_us_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    static void print(const DeadlineStats &s, FILE *out = stdout) {
+        std::fprintf(out, "%s: period %lu us, %lu iterations, actual %lld/%lld/%lld us (min/mean/max), "
+                     "exec %lld/%lld us (mean/max), %lu overruns, worst %lld us late\n",
+                     s.name, static_cast<unsigned long>(s.period_us), static_cast<unsigned long>(s.iterations),
+                     static_cast<long long>(s.min_period_us), static_cast<long long>(s.mean_period_us),
+                     static_cast<long long>(s.max_period_us), static_cast<long long>(s.mean_exec_us),
+                     static_cast<long long>(s.max_exec_us), static_cast<unsigned long>(s.overruns),
+                     static_cast<long long>(s.worst_lateness_us));
+    }
+
+    // Prints every registered loop
+    static void report(FILE *out = stdout) {
+        for(auto &slot : registry_) {
+            const DeadlineMonitor *m = slot.load(std::memory_order_acquire);
+            if(m) {
+                print(m->stats(), out);
+            }
+        }
+        std::fflush(out);
+    }
+
+    // Linux: SIGUSR1 requests a report. ESP32: nothing to install, the console is polled
+    static void enableReportTrigger() {
+#if !defined(ESP_PLATFORM)
+        std::signal(SIGUSR1, deadline_detail::onReportSignal);
+#endif
+    }
+
+    static bool reportRequested() {
+#if defined(ESP_PLATFORM)
+        // the default console doesn't block, no key pressed is EOF
+        int c = std::fgetc(stdin);
+        if(c == EOF) {
+            std::clearerr(stdin);
+        }
+        return c == 'd';
+#else
+        if(deadline_detail::reportSignalled) {
+            deadline_detail::reportSignalled = 0;
+            return true;
+        }
+        return false;
+#endif
+    }
+
+    // Call once per iteration from any monitored loop
+    static void reportIfRequested(FILE *out = stdout) {
+        if(reportRequested()) {
+            report(out);
+        }
+    }
+};
@@ -0,0 +1,97 @@
+/*
+    Oversampling and decimation: 4^n samples of an N-bit ADC summed and shifted right by n give one N+n bit result.
+    The shift rounds to nearest (adds half an output LSB first), plain truncation would read half an LSB low.
+
+    Works only when there is at least about 1 LSB of noise on the input (true for the ESP32 ADC and usually for the
+    MCP3008 with a pot or LDR on it), otherwise every sample is the same code and the extra bits are just zeros.
+    The output rate is the input rate / 4^n, so 4 extra bits on a 1 kHz stream leave ~4 Hz.
+
+    Plain C++17 without platform headers, shared by the Raspberry Pi (MCP3008 readings) and the ESP32 (adc_oneshot
+    or adc_continuous buffers). ESP32 continuous mode hands out 16-bit words with the channel in the top 4 bits
+    (type 1 format), sample_mask 0x0FFF strips it.
+
+    process() takes blocks of any size and carries partial groups over to the next call. Whole groups go through
+    sumGroup(), a plain counted loop over uint16 into a uint32 accumulator that GCC turns into NEON / SSE2 / Xtensa
+    loop code at -O2 -ftree-vectorize (-O3 on older GCC), there's nothing target specific in here.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+class Oversampler {
+private:
+    unsigned extra_bits_;
+    std::size_t group_;             // 4^extra_bits
+    std::uint16_t mask_;
+    std::uint32_t partial_sum_ = 0;
+    std::size_t partial_count_ = 0;
+
+    static std::uint32_t sumGroup(const std::uint16_t *in, std::size_t n, std::uint16_t mask) {
+        std::uint32_t sum = 0;
+        for(std::size_t i = 0; i < n; i++) {
+            sum += in[i] & mask;
+        }
+        return sum;
+    }
+
+    std::uint32_t decimate(std::uint32_t sum) const {
+        return extra_bits_ == 0 ? sum : (sum + (std::uint32_t(1) << (extra_bits_ - 1))) >> extra_bits_;
+    }
+
+public:
+    static constexpr unsigned maxExtraBits = 6;     // 4096 samples, 12-bit input still fits the uint32 sum
+
+    explicit Oversampler(unsigned extra_bits, std::uint16_t sample_mask = 0xFFFF)
+        : extra_bits_(extra_bits > maxExtraBits ? maxExtraBits : extra_bits),
+          group_(std::size_t(1) << (2 * (extra_bits > maxExtraBits ? maxExtraBits : extra_bits))),
+          mask_(sample_mask)
+    {
+    }
+
+    // Feeds count samples, writes one output per completed group to out (room for count / groupSize() + 1),
+    // returns the number of outputs written
+    std::size_t process(const std::uint16_t *in, std::size_t count, std::uint32_t *out) {
+        std::size_t produced = 0;
+        std::size_t i = 0;
+
+        if(partial_count_ > 0) {
+            std::size_t take = group_ - partial_count_;
+            if(take > count) {
+                take = count;
+            }
+            partial_sum_ += sumGroup(in, take, mask_);
+            partial_count_ += take;
+            i = take;
+            if(partial_count_ < group_) {
+                return 0;
+            }
+            out[produced++] = decimate(partial_sum_);
+            partial_sum_ = 0;
+            partial_count_ = 0;
+        }
+
+        for(; i + group_ <= count; i += group_) {
+            out[produced++] = decimate(sumGroup(in + i, group_, mask_));
+        }
+
+        if(i < count) {
+            partial_sum_ = sumGroup(in + i, count - i, mask_);
+            partial_count_ = count - i;
+        }
+        return produced;
+    }
+
+    void reset() {
+        partial_sum_ = 0;
+        partial_count_ = 0;
+    }
+
+    unsigned extraBits() const { return extra_bits_; }
+    std::size_t groupSize() const { return group_; }
+    std::size_t pending() const { return partial_count_; }
+
+    // Full-scale value of the output for an input_bits ADC, e.g. 10-bit MCP3008 with 3 extra bits -> 8191
+    std::uint32_t fullScale(unsigned input_bits) const { return (std::uint32_t(1) << (input_bits + extra_bits_)) - 1; }
+};
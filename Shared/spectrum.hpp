@@ -0,0 +1,247 @@
+/*
+    Streaming magnitude spectrum for vibration monitoring on an ADC stream.
+
+    Spectrum takes samples in blocks of any size and, every hop samples, runs one frame over the last n samples:
+
+        1. subtract the frame mean (the pot / accelerometer offset would otherwise swamp bin 0 and its leakage)
+        2. multiply by the window (Hann by default), table computed once
+        3. real FFT of size n: an n/2-point complex radix-2 FFT on the even/odd samples packed as re/im, then one
+           split pass to get the n/2 + 1 real-input bins. Bit-reversal and both twiddle tables are precomputed.
+        4. amplitude per bin, scaled so a full-scale sine of amplitude A reads A in its bin
+        5. peaks: local maxima above a threshold, refined with parabolic interpolation on the log magnitude,
+           strongest first
+
+    All buffers are sized in the constructor, processing a frame doesn't allocate. Plain C++17, so the same
+    stage builds for the ESP32 ADC as well.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+enum class SpectrumWindow {
+    Rectangular,
+    Hann,
+    BlackmanHarris     // lower leakage for small peaks next to big ones, wider main lobe
+};
+
+struct SpectrumPeak {
+    float frequency_hz;     // interpolated between bins
+    float amplitude;        // same units as the input samples
+    std::uint32_t bin;
+};
+
+// n-point FFT of real input, n a power of two >= 4
+class RealFft {
+private:
+    using cf = std::complex<float>;
+
+    std::size_t n_;
+    std::vector<std::uint32_t> bitrev_;     // n/2 entries
+    std::vector<cf> twiddle_;               // exp(-2 pi i k / (n/2)), k < n/4
+    std::vector<cf> split_;                 // exp(-2 pi i k / n), k <= n/2
+    std::vector<cf> work_;
+
+public:
+    explicit RealFft(std::size_t n) : n_(n) {
+        if(n < 4 || (n & (n - 1)) != 0) {
+            throw std::invalid_argument("FFT size must be a power of two >= 4");
+        }
+        const std::size_t half = n / 2;
+        unsigned bits = 0;
+        while((std::size_t(1) << bits) < half) {
+            bits++;
+        }
+        bitrev_.resize(half);
+        for(std::size_t i = 0; i < half; i++) {
+            std::uint32_t r = 0;
+            for(unsigned b = 0; b < bits; b++) {
+                r |= ((i >> b) & 1u) << (bits - 1 - b);
+            }
+            bitrev_[i] = r;
+        }
+        twiddle_.resize(half / 2 > 0 ? half / 2 : 1);
+        for(std::size_t k = 0; k < twiddle_.size(); k++) {
+            double a = -2 * M_PI * k / half;
+            twiddle_[k] = cf(float(std::cos(a)), float(std::sin(a)));
+        }
+        split_.resize(half + 1);
+        for(std::size_t k = 0; k <= half; k++) {
+            double a = -2 * M_PI * k / n;
+            split_[k] = cf(float(std::cos(a)), float(std::sin(a)));
+        }
+        work_.resize(half);
+    }
+
+    // in: n real samples, out: n/2 + 1 bins (DC .. Nyquist)
+    void forward(const float *in, std::complex<float> *out) {
+        const std::size_t half = n_ / 2;
+        for(std::size_t i = 0; i < half; i++) {
+            work_[bitrev_[i]] = cf(in[2 * i], in[2 * i + 1]);
+        }
+
+        // iterative radix-2 decimation in time
+        for(std::size_t len = 2; len <= half; len <<= 1) {
+            const std::size_t step = half / len;
+            const std::size_t hl = len / 2;
+            for(std::size_t start = 0; start < half; start += len) {
+                cf *a = &work_[start];
+                cf *b = a + hl;
+                for(std::size_t j = 0; j < hl; j++) {
+                    cf t = b[j] * twiddle_[j * step];
+                    b[j] = a[j] - t;
+                    a[j] = a[j] + t;
+                }
+            }
+        }
+
+        // split the packed even/odd transform into the real-input spectrum
+        out[0] = cf(work_[0].real() + work_[0].imag(), 0);
+        out[half] = cf(work_[0].real() - work_[0].imag(), 0);
+        for(std::size_t k = 1; k < half; k++) {
+            cf zk = work_[k];
+            cf zc = std::conj(work_[half - k]);
+            cf even = (zk + zc) * 0.5f;
+            cf odd = (zk - zc) * cf(0, -0.5f);
+            out[k] = even + split_[k] * odd;
+        }
+    }
+
+    std::size_t size() const { return n_; }
+};
+
+class Spectrum {
+private:
+    std::size_t n_;
+    std::size_t hop_;
+    float sample_rate_;
+    RealFft fft_;
+    std::vector<float> window_;
+    float amplitude_scale_;
+    std::vector<float> ring_;               // last n samples, power-of-two ring
+    std::size_t written_ = 0;               // total samples pushed
+    std::size_t since_frame_ = 0;
+    std::vector<float> frame_;
+    std::vector<std::complex<float>> bins_;
+    std::vector<float> magnitude_;
+    std::vector<SpectrumPeak> peaks_;
+    std::size_t peak_count_ = 0;
+    float peak_threshold_;
+    std::uint64_t frames_ = 0;
+
+    void runFrame() {
+        const std::size_t mask = n_ - 1;
+        const std::size_t start = written_ & mask;     // oldest sample of the last n
+        double mean = 0;
+        for(std::size_t i = 0; i < n_; i++) {
+            frame_[i] = ring_[(start + i) & mask];
+            mean += frame_[i];
+        }
+        const float m = static_cast<float>(mean / n_);
+        for(std::size_t i = 0; i < n_; i++) {
+            frame_[i] = (frame_[i] - m) * window_[i];
+        }
+
+        fft_.forward(frame_.data(), bins_.data());
+        for(std::size_t k = 0; k < magnitude_.size(); k++) {
+            magnitude_[k] = std::abs(bins_[k]) * amplitude_scale_;
+        }
+        magnitude_[0] *= 0.5f;
+        magnitude_.back() *= 0.5f;
+
+        findPeaks();
+        frames_++;
+    }
+
+    void findPeaks() {
+        peak_count_ = 0;
+        const float binHz = sample_rate_ / n_;
+        for(std::size_t k = 1; k + 1 < magnitude_.size(); k++) {
+            float m = magnitude_[k];
+            if(m < peak_threshold_ || m < magnitude_[k - 1] || m <= magnitude_[k + 1]) {
+                continue;
+            }
+            // parabola through the log magnitudes of the three bins
+            float a = std::log(magnitude_[k - 1] + 1e-20f), b = std::log(m), c = std::log(magnitude_[k + 1] + 1e-20f);
+            float denom = a - 2 * b + c;
+            float delta = denom < 0 ? 0.5f * (a - c) / denom : 0.0f;
+            SpectrumPeak p = {(k + delta) * binHz, std::exp(b - 0.25f * (a - c) * delta), static_cast<std::uint32_t>(k)};
+
+            // keep the strongest peaks_.size() sorted by amplitude, insertion into a short array
+            std::size_t pos = peak_count_;
+            while(pos > 0 && peaks_[pos - 1].amplitude < p.amplitude) {
+                pos--;
+            }
+            if(pos >= peaks_.size()) {
+                continue;
+            }
+            std::size_t last = std::min(peak_count_, peaks_.size() - 1);
+            for(std::size_t i = last; i > pos; i--) {
+                peaks_[i] = peaks_[i - 1];
+            }
+            peaks_[pos] = p;
+            if(peak_count_ < peaks_.size()) {
+                peak_count_++;
+            }
+        }
+    }
+
+public:
+    // n: FFT size (power of two), hop: samples between frames (n / 2 = 50 % overlap)
+    Spectrum(std::size_t n, std::size_t hop, float sample_rate, SpectrumWindow window = SpectrumWindow::Hann,
+             std::size_t max_peaks = 8, float peak_threshold = 0)
+        : n_(n), hop_(hop ? hop : n), sample_rate_(sample_rate), fft_(n), window_(n), ring_(n, 0.0f), frame_(n),
+          bins_(n / 2 + 1), magnitude_(n / 2 + 1), peaks_(max_peaks), peak_threshold_(peak_threshold)
+    {
+        double sum = 0;
+        for(std::size_t i = 0; i < n; i++) {
+            double x = 2 * M_PI * i / n;   // periodic form, the right one for spectral analysis
+            switch(window) {
+            case SpectrumWindow::Rectangular:
+                window_[i] = 1.0f;
+                break;
+            case SpectrumWindow::Hann:
+                window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(x));
+                break;
+            case SpectrumWindow::BlackmanHarris:
+                window_[i] = static_cast<float>(0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2 * x) - 0.01168 * std::cos(3 * x));
+                break;
+            }
+            sum += window_[i];
+        }
+        amplitude_scale_ = static_cast<float>(2.0 / sum);
+    }
+
+    // Pushes samples, returns how many frames completed (the results are those of the last one)
+    template <typename T>
+    std::size_t push(const T *samples, std::size_t count) {
+        const std::size_t mask = n_ - 1;
+        std::size_t frames = 0;
+        for(std::size_t i = 0; i < count; i++) {
+            ring_[written_ & mask] = static_cast<float>(samples[i]);
+            written_++;
+            if(++since_frame_ >= hop_ && written_ >= n_) {
+                since_frame_ = 0;
+                runFrame();
+                frames++;
+            }
+        }
+        return frames;
+    }
+
+    void setSampleRate(float sample_rate) { sample_rate_ = sample_rate; }
+    float sampleRate() const { return sample_rate_; }
+    float binHz() const { return sample_rate_ / n_; }
+    std::size_t size() const { return n_; }
+
+    const std::vector<float> &magnitudes() const { return magnitude_; }
+    const SpectrumPeak *peaks() const { return peaks_.data(); }
+    std::size_t peakCount() const { return peak_count_; }
+    std::uint64_t frames() const { return frames_; }
+};
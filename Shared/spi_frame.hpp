@@ -0,0 +1,321 @@
+/*
+    Framing for the Pi SPI master -> ESP32 SPI slave stream: a fixed 16-byte header with type, sequence number,
+    payload length and CRC32, so several frames fit in one SPI transaction and a corrupted or missing frame is
+    noticed instead of turning into a wrong sample.
+
+        offset  size
+        0       2       magic 0x5346 ("FS" on the wire, little-endian like every field)
+        2       1       type: Samples (uint16 values) or Command (opcode + 32-bit value)
+        3       1       flags, 0 for now
+        4       4       sequence number, +1 per frame
+        8       2       payload length in bytes
+        10      2       reserved, 0
+        12      4       CRC32 (IEEE, as zlib) of bytes 0-11 and the payload
+        16      n       payload, then zero padding to the next multiple of 4
+
+    SpiFrameWriter packs frames into a transaction buffer and zero-fills the rest (the ESP32 slave DMA wants whole
+    words, and a zero magic marks the end). SpiFrameReader walks a received buffer; SpiFrameReceiver does that for
+    every buffer, checks the sequence numbers and keeps the error counts.
+
+    Plain C++17, shared by the Pi master (SPI ESP32 slave/spi_frame_master.cpp), the ESP32 slave
+    (ESP32/SPI/spi_slave_frames.cpp) and the host loopback check (SPI ESP32 slave/spi_frame_loopback.cpp).
+    The CRC is a 256-entry table, one lookup per byte.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+
+enum class SpiFrameType : std::uint8_t {
+    Padding = 0,
+    Samples = 1,
+    Command = 2
+};
+
+enum class SpiFrameStatus {
+    Ok,
+    End,            // rest of the buffer is padding or too short for a header
+    BadMagic,       // not at a frame boundary, the rest of the buffer is skipped
+    BadLength,      // payload would run past the buffer, rest skipped
+    BadCrc          // header plausible, contents damaged; skipped, the reader goes on after it
+};
+
+struct SpiFrameHeader {
+    SpiFrameType type;
+    std::uint8_t flags;
+    std::uint32_t seq;
+    std::uint16_t length;
+    std::uint32_t crc;
+};
+
+struct SpiFrame {
+    SpiFrameHeader header;
+    const std::uint8_t *payload;
+
+    std::size_t sampleCount() const { return header.length / 2; }
+    std::uint16_t sample(std::size_t i) const {
+        return static_cast<std::uint16_t>(payload[2 * i] | (payload[2 * i + 1] << 8));
+    }
+    std::uint8_t opcode() const { return payload[0]; }
+    std::uint32_t value() const {
+        return payload[4] | (payload[5] << 8) | (payload[6] << 16) | (static_cast<std::uint32_t>(payload[7]) << 24);
+    }
+};
+
+namespace spi_frame {
+
+constexpr std::uint16_t magic = 0x5346;
+constexpr std::size_t headerSize = 16;
+constexpr std::size_t commandSize = 8;      // opcode, 3 reserved bytes, value
+
+constexpr std::array<std::uint32_t, 256> makeCrcTable() {
+    std::array<std::uint32_t, 256> table{};
+    for(std::uint32_t i = 0; i < 256; i++) {
+        std::uint32_t c = i;
+        for(int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+inline constexpr std::array<std::uint32_t, 256> crcTable = makeCrcTable();
+
+// Continues crc over data, start with 0; crc32("123456789") == 0xCBF43926
+inline std::uint32_t crc32(const std::uint8_t *data, std::size_t len, std::uint32_t crc = 0) {
+    crc = ~crc;
+    for(std::size_t i = 0; i < len; i++) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+constexpr std::size_t align4(std::size_t n) {
+    return (n + 3) & ~std::size_t(3);
+}
+
+// Bytes a frame with this payload takes in the buffer
+constexpr std::size_t frameSize(std::size_t payload_len) {
+    return align4(headerSize + payload_len);
+}
+
+inline void put16(std::uint8_t *p, std::uint16_t v) {
+    p[0] = static_cast<std::uint8_t>(v);
+    p[1] = static_cast<std::uint8_t>(v >> 8);
+}
+
+inline void put32(std::uint8_t *p, std::uint32_t v) {
+    p[0] = static_cast<std::uint8_t>(v);
+    p[1] = static_cast<std::uint8_t>(v >> 8);
+    p[2] = static_cast<std::uint8_t>(v >> 16);
+    p[3] = static_cast<std::uint8_t>(v >> 24);
+}
+
+inline std::uint16_t get16(const std::uint8_t *p) {
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline std::uint32_t get32(const std::uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+}
+
+class SpiFrameWriter {
+private:
+    std::uint8_t *buf_;
+    std::size_t capacity_;
+    std::size_t used_ = 0;
+    std::uint32_t &seq_;
+    std::size_t frames_ = 0;
+
+    // Writes the header with the CRC over header and the payload already in place behind it
+    void seal(std::uint8_t *f, SpiFrameType type, std::uint16_t len) {
+        spi_frame::put16(f, spi_frame::magic);
+        f[2] = static_cast<std::uint8_t>(type);
+        f[3] = 0;
+        spi_frame::put32(f + 4, seq_++);
+        spi_frame::put16(f + 8, len);
+        spi_frame::put16(f + 10, 0);
+        std::uint32_t crc = spi_frame::crc32(f, 12);
+        crc = spi_frame::crc32(f + spi_frame::headerSize, len, crc);
+        spi_frame::put32(f + 12, crc);
+        std::size_t size = spi_frame::frameSize(len);
+        std::memset(f + spi_frame::headerSize + len, 0, size - spi_frame::headerSize - len);
+        used_ += size;
+        frames_++;
+    }
+
+public:
+    // seq is the running sequence number, kept by the caller across buffers
+    SpiFrameWriter(std::uint8_t *buf, std::size_t capacity, std::uint32_t &seq)
+        : buf_(buf), capacity_(capacity & ~std::size_t(3)), seq_(seq)
+    {
+    }
+
+    bool fits(std::size_t payload_len) const {
+        return payload_len <= 0xFFFF && used_ + spi_frame::frameSize(payload_len) <= capacity_;
+    }
+
+    // Largest number of samples the next frame can take
+    std::size_t sampleRoom() const {
+        if(used_ + spi_frame::headerSize >= capacity_) {
+            return 0;
+        }
+        std::size_t room = (capacity_ - used_ - spi_frame::headerSize) / 2;
+        return room > 0x7FFF ? 0x7FFF : room;
+    }
+
+    bool add(SpiFrameType type, const std::uint8_t *payload, std::size_t len) {
+        if(!fits(len)) {
+            return false;
+        }
+        std::uint8_t *f = buf_ + used_;
+        if(len) {
+            std::memcpy(f + spi_frame::headerSize, payload, len);
+        }
+        seal(f, type, static_cast<std::uint16_t>(len));
+        return true;
+    }
+
+    bool addSamples(const std::uint16_t *samples, std::size_t count) {
+        std::size_t len = 2 * count;
+        if(!fits(len)) {
+            return false;
+        }
+        std::uint8_t *f = buf_ + used_;
+        for(std::size_t i = 0; i < count; i++) {
+            spi_frame::put16(f + spi_frame::headerSize + 2 * i, samples[i]);
+        }
+        seal(f, SpiFrameType::Samples, static_cast<std::uint16_t>(len));
+        return true;
+    }
+
+    bool addCommand(std::uint8_t opcode, std::uint32_t value) {
+        std::uint8_t payload[spi_frame::commandSize] = {opcode, 0, 0, 0};
+        spi_frame::put32(payload + 4, value);
+        return add(SpiFrameType::Command, payload, sizeof(payload));
+    }
+
+    // Zero-fills the rest of the buffer, returns the bytes that carry frames
+    std::size_t finish() {
+        std::memset(buf_ + used_, 0, capacity_ - used_);
+        return used_;
+    }
+
+    // Starts over at the beginning of the buffer, the sequence number carries on
+    void reset() {
+        used_ = 0;
+        frames_ = 0;
+    }
+
+    std::size_t used() const { return used_; }
+    std::size_t frames() const { return frames_; }
+};
+
+class SpiFrameReader {
+private:
+    const std::uint8_t *buf_;
+    std::size_t len_;
+    std::size_t pos_ = 0;
+
+public:
+    SpiFrameReader(const std::uint8_t *buf, std::size_t len) : buf_(buf), len_(len) {}
+
+    SpiFrameStatus next(SpiFrame &frame) {
+        if(len_ - pos_ < spi_frame::headerSize) {
+            pos_ = len_;
+            return SpiFrameStatus::End;
+        }
+        const std::uint8_t *f = buf_ + pos_;
+        std::uint16_t m = spi_frame::get16(f);
+        if(m != spi_frame::magic) {
+            pos_ = len_;
+            return m == 0 && f[2] == 0 ? SpiFrameStatus::End : SpiFrameStatus::BadMagic;
+        }
+        frame.header.type = static_cast<SpiFrameType>(f[2]);
+        frame.header.flags = f[3];
+        frame.header.seq = spi_frame::get32(f + 4);
+        frame.header.length = spi_frame::get16(f + 8);
+        frame.header.crc = spi_frame::get32(f + 12);
+        frame.payload = f + spi_frame::headerSize;
+
+        std::size_t size = spi_frame::frameSize(frame.header.length);
+        if(size > len_ - pos_) {
+            pos_ = len_;
+            return SpiFrameStatus::BadLength;
+        }
+        pos_ += size;
+
+        std::uint32_t crc = spi_frame::crc32(f, 12);
+        crc = spi_frame::crc32(frame.payload, frame.header.length, crc);
+        return crc == frame.header.crc ? SpiFrameStatus::Ok : SpiFrameStatus::BadCrc;
+    }
+};
+
+struct SpiFrameStats {
+    std::uint64_t buffers = 0;
+    std::uint64_t frames = 0;           // good frames
+    std::uint64_t payloadBytes = 0;
+    std::uint64_t crcErrors = 0;
+    std::uint64_t headerErrors = 0;     // bad magic or length, the rest of that buffer is lost; also command
+                                        // frames shorter than commandSize, which are not passed on
+    std::uint64_t lostFrames = 0;       // sequence numbers never seen (includes the damaged ones)
+    std::uint64_t reordered = 0;        // sequence went backwards, e.g. the master restarted
+};
+
+class SpiFrameReceiver {
+private:
+    SpiFrameStats stats_;
+    std::uint32_t expected_ = 0;
+    bool synced_ = false;
+
+public:
+    // Calls handler(const SpiFrame&) for every good frame in the buffer, so a Command frame handed over
+    // always has its opcode and value
+    template <typename Handler>
+    void process(const std::uint8_t *buf, std::size_t len, Handler &&handler) {
+        stats_.buffers++;
+        SpiFrameReader reader(buf, len);
+        SpiFrame frame;
+        while(true) {
+            SpiFrameStatus status = reader.next(frame);
+            if(status == SpiFrameStatus::End) {
+                break;
+            }
+            if(status == SpiFrameStatus::BadMagic || status == SpiFrameStatus::BadLength) {
+                stats_.headerErrors++;
+                break;
+            }
+            if(status == SpiFrameStatus::BadCrc) {
+                stats_.crcErrors++;
+                continue;
+            }
+
+            std::uint32_t seq = frame.header.seq;
+            if(synced_ && seq != expected_) {
+                std::int32_t gap = static_cast<std::int32_t>(seq - expected_);
+                if(gap > 0) {
+                    stats_.lostFrames += static_cast<std::uint32_t>(gap);
+                } else {
+                    stats_.reordered++;
+                }
+            }
+            expected_ = seq + 1;
+            synced_ = true;
+            if(frame.header.type == SpiFrameType::Command && frame.header.length < spi_frame::commandSize) {
+                stats_.headerErrors++;
+                continue;
+            }
+            stats_.frames++;
+            stats_.payloadBytes += frame.header.length;
+            handler(frame);
+        }
+    }
+
+    const SpiFrameStats &stats() const { return stats_; }
+};